@@ -464,6 +464,18 @@ static void InvCipher(state_t* state, const uint8_t* RoundKey)
 /*****************************************************************************/
 /* Public functions:                                                         */
 /*****************************************************************************/
+uint8_t AES_SubByte(uint8_t x)
+{
+  return getSBoxValue(x);
+}
+
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+uint8_t AES_InvSubByte(uint8_t x)
+{
+  return getSBoxInvert(x);
+}
+#endif
+
 #if defined(ECB) && (ECB == 1)
 
 
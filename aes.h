@@ -88,4 +88,11 @@ void AES_CTR_xcrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length);
 #endif // #if defined(CTR) && (CTR == 1)
 
 
+// Single-byte S-box lookups, exposed for leakage modelling of AES intermediates.
+uint8_t AES_SubByte(uint8_t x);
+#if (defined(CBC) && (CBC == 1)) || (defined(ECB) && (ECB == 1))
+uint8_t AES_InvSubByte(uint8_t x);
+#endif
+
+
 #endif // _AES_H_
@@ -0,0 +1,118 @@
+// Created by Team "RTL Rangers"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+struct ArenaChunk {
+    ArenaChunk *prev;
+    size_t size;
+    _Alignas(max_align_t) unsigned char data[];
+};
+
+static __thread Arena thread_arena;
+static __thread int thread_arena_ready;
+
+static ArenaChunk *chunk_new(Arena *arena, size_t size, ArenaChunk *prev) {
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) return NULL;
+    arena->heap_calls++;
+    chunk->prev = prev;
+    chunk->size = size;
+    return chunk;
+}
+
+static void chunks_free(Arena *arena) {
+    while (arena->chunk) {
+        ArenaChunk *prev = arena->chunk->prev;
+        free(arena->chunk);
+        arena->heap_calls++;
+        arena->chunk = prev;
+    }
+}
+
+int arena_init(Arena *arena, size_t size) {
+    arena->chunk = NULL;
+    arena->used = 0;
+    arena->in_use = 0;
+    arena->bytes_allocated = 0;
+    arena->allocations = 0;
+    arena->high_water = 0;
+    arena->heap_calls = 0;
+
+    arena->chunk = chunk_new(arena, size ? size : ARENA_DEFAULT_SIZE, NULL);
+    return arena->chunk ? 0 : -1;
+}
+
+void arena_destroy(Arena *arena) {
+    chunks_free(arena);
+    arena->used = 0;
+    arena->in_use = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size == 0) size = ARENA_ALIGN;
+
+    if (!arena->chunk || arena->chunk->size - arena->used < size) {
+        // Grow geometrically so a large batch needs few chunks
+        size_t next = arena->chunk ? arena->chunk->size * 2 : ARENA_DEFAULT_SIZE;
+        if (next < size) next = size;
+        ArenaChunk *chunk = chunk_new(arena, next, arena->chunk);
+        if (!chunk) return NULL;
+        arena->chunk = chunk;
+        arena->used = 0;
+    }
+
+    void *p = arena->chunk->data + arena->used;
+    arena->used += size;
+    arena->in_use += size;
+    arena->bytes_allocated += size;
+    arena->allocations++;
+    if (arena->in_use > arena->high_water) arena->high_water = arena->in_use;
+    return p;
+}
+
+char *arena_printf(Arena *arena, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (len < 0) return NULL;
+
+    char *str = arena_alloc(arena, (size_t)len + 1);
+    if (!str) return NULL;
+    va_start(args, fmt);
+    vsnprintf(str, (size_t)len + 1, fmt, args);
+    va_end(args);
+    return str;
+}
+
+void arena_reset(Arena *arena) {
+    // Several chunks: replace them by one that holds the whole high-water mark
+    if (arena->chunk && arena->chunk->prev) {
+        size_t total = arena->high_water > arena->chunk->size ? arena->high_water : arena->chunk->size;
+        chunks_free(arena);
+        arena->chunk = chunk_new(arena, total, NULL);
+    }
+    arena->used = 0;
+    arena->in_use = 0;
+}
+
+Arena *arena_thread(void) {
+    if (!thread_arena_ready) {
+        if (arena_init(&thread_arena, 0) != 0) return NULL;
+        thread_arena_ready = 1;
+    }
+    return &thread_arena;
+}
+
+void arena_thread_destroy(void) {
+    if (thread_arena_ready) {
+        arena_destroy(&thread_arena);
+        thread_arena_ready = 0;
+    }
+}
@@ -0,0 +1,50 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for per-sample scratch memory (strings, state buffers,
+// hypothesis rows). Allocations are never freed one by one; arena_reset
+// drops everything at the end of a sample or batch. When a batch outgrows
+// the current chunk, extra chunks are chained, and the next reset merges
+// them into one chunk big enough for the high-water mark, so steady-state
+// processing makes no heap calls at all.
+
+#define ARENA_DEFAULT_SIZE (64 * 1024)
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk *chunk;      // current chunk, earlier ones chained behind it
+    size_t used;            // bytes used in the current chunk
+    size_t in_use;          // bytes handed out since the last reset (all chunks)
+
+    // Statistics since arena_init
+    uint64_t bytes_allocated;
+    uint64_t allocations;
+    size_t high_water;      // max in_use between two resets
+    uint64_t heap_calls;    // malloc/free of chunks
+} Arena;
+
+// Return 0, or -1 if the first chunk cannot be allocated. size 0 = default.
+int arena_init(Arena *arena, size_t size);
+void arena_destroy(Arena *arena);
+
+// `size` bytes aligned for any type. Return NULL only if a new chunk is needed
+// and the heap is exhausted.
+void *arena_alloc(Arena *arena, size_t size);
+
+// printf into arena memory. Return NULL on allocation failure.
+char *arena_printf(Arena *arena, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void arena_reset(Arena *arena);
+
+// The calling thread's arena, created on first use with the default size.
+// Release it with arena_thread_destroy before the thread exits.
+Arena *arena_thread(void);
+void arena_thread_destroy(void);
+
+#endif // _ARENA_H_
@@ -0,0 +1,813 @@
+// Created by Team "RTL Rangers"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cpa.h"
+#include "cpa2.h"
+#include "csv_loader.h"
+#include "key_rank.h"
+#include "leakage.h"
+#include "poi.h"
+#include "sca_config.h"
+#include "template.h"
+#include "trace_store.h"
+#include "trace_stream.h"
+
+// Traces per read-ahead batch with --stream
+#define STREAM_BATCH 1024
+
+typedef struct {
+    const char *mode;
+    const char *input;
+    size_t max_traces;
+    int csv_length;
+    int threads;
+    int byte;
+    LeakTarget target;
+    LeakModel model;
+    int start, end, window;
+    PoiMetric metric;
+    int poi_count;
+    int min_distance;
+    int pca_components;
+    int hw_classes;
+    const char *output;
+    const char *template_file;
+    const char *reduction;
+    size_t step;
+    int experiments;
+    int bins;
+    int stream;
+} AttackOptions;
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options] TRACE_FILE\n", prog);
+    printf("  -m, --mode MODE       cpa2 (default), poi, template-build, template or rank\n");
+    printf("  -n, --traces N        use at most N traces (CSV default %d)\n", NUM_SAMPLES);
+    printf("  -l, --length L        samples per CSV row (default %d)\n", TRACE_LENGTH);
+    printf("  -t, --threads T       worker threads (default: all CPUs)\n");
+    printf("      --stream          cpa2, rank: read a binary trace file batch by batch\n");
+    printf("                        instead of loading it into memory\n");
+    printf("  -b, --byte B          key byte to attack (default 0)\n");
+    printf("      --target T        sbox or last (default sbox)\n");
+    printf("      --model M         hw or hd (default hw)\n");
+    printf("      --start S         first sample of the analysed region\n");
+    printf("      --end E           end of the analysed region (exclusive)\n");
+    printf("      --window W        cpa2: max distance between combined samples\n");
+    printf("      --metric M        poi: snr (default) or sost\n");
+    printf("  -k, --poi K           poi: number of points to keep (default 20)\n");
+    printf("      --min-distance D  poi: minimum distance between kept points (default 1)\n");
+    printf("      --pca C           poi: project on C PCA components instead\n");
+    printf("      --hw-classes      poi: classes by HW of the intermediate, not its value\n");
+    printf("  -o, --output FILE     poi: write the reduced traces as a binary trace file,\n");
+    printf("                        and the reduction itself to FILE.red\n");
+    printf("                        template-build: template file to write\n");
+    printf("      --reduction FILE  reduction saved by poi: poi applies it instead of\n");
+    printf("                        selecting points, the template modes reduce full\n");
+    printf("                        length traces with it before use\n");
+    printf("      --template FILE   template: profile built by template-build\n");
+    printf("                        rank: score with templates instead of CPA; a %%d in\n");
+    printf("                        FILE is replaced by the byte number to load all 16\n");
+    printf("      --step S          rank: traces between evaluation points (default 100)\n");
+    printf("      --experiments E   rank: split the traces into E independent attacks\n");
+    printf("      --bins N          rank: histogram bins per byte (default %d)\n",
+           KEY_RANK_DEFAULT_BINS);
+}
+
+// Binary trace files are recognised by their magic, anything else is read as CSV
+static long load_traces(const AttackOptions *opt, TraceSet *set) {
+    FILE *file = fopen(opt->input, "rb");
+    if (!file) {
+        printf("Error: Cannot open file %s\n", opt->input);
+        return -1;
+    }
+    char magic[8] = { 0 };
+    size_t got = fread(magic, 1, 8, file);
+    fclose(file);
+
+    if (got == 8 && memcmp(magic, TRACE_FILE_MAGIC, 8) == 0) {
+        return trace_store_load(opt->input, set, opt->max_traces);
+    }
+
+    size_t rows = opt->max_traces ? opt->max_traces : NUM_SAMPLES;
+    if (trace_set_alloc(set, rows, opt->csv_length) != 0) {
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    long n = csv_load_parallel(opt->input, set, opt->threads);
+    if (n < 0) {
+        trace_set_free(set);
+        return -1;
+    }
+    set->num_traces = (size_t)n;
+    return n;
+}
+
+// Template modes with --reduction: full length traces are reduced like the
+// profiling set, traces that are already reduced are used as they are.
+// The loaded reduction is kept in `red` for template-build.
+static int reduce_input(const AttackOptions *opt, TraceSet *set, PoiReduction *red) {
+    if (poi_reduction_load(opt->reduction, red) != 0) return -1;
+
+    if (set->trace_length == red->input_length) {
+        TraceSet reduced;
+        if (poi_reduction_apply(red, set, &reduced, opt->threads) != 0) return -1;
+        trace_set_free(set);
+        *set = reduced;
+    } else if (set->trace_length != red->output_length) {
+        printf("Error: Traces of %d samples match neither side of reduction %s (%d -> %d)\n",
+               set->trace_length, opt->reduction, red->input_length, red->output_length);
+        return -1;
+    }
+    return 0;
+}
+
+static TraceSet subset_view(const TraceSet *set, size_t first, size_t count) {
+    TraceSet view = *set;
+    view.num_traces = count;
+    view.plaintexts += first;
+    view.ciphertexts += first;
+    view.keys += first;
+    view.traces = trace_set_row(set, first);
+    view.owns_memory = 0;
+    return view;
+}
+
+// Batches come from the loaded set, or with --stream straight from a binary
+// trace file, read ahead while the previous batch is being processed
+typedef struct {
+    const TraceSet *set;
+    TraceStream *stream;
+    TraceSet pending;       // rest of the current stream batch
+    size_t num_traces;
+    int trace_length;
+    size_t pos;             // traces handed out so far
+} BatchSource;
+
+static int source_rewind(BatchSource *src, const AttackOptions *opt) {
+    src->pos = 0;
+    memset(&src->pending, 0, sizeof(src->pending));
+    if (!opt->stream) return 0;
+
+    trace_stream_close(src->stream);
+    src->stream = trace_stream_open(opt->input, STREAM_BATCH, opt->max_traces, opt->threads);
+    return src->stream ? 0 : -1;
+}
+
+static int source_open(BatchSource *src, const AttackOptions *opt, const TraceSet *set) {
+    memset(src, 0, sizeof(*src));
+    if (!opt->stream) {
+        src->set = set;
+        src->num_traces = set->num_traces;
+        src->trace_length = set->trace_length;
+        return 0;
+    }
+    if (source_rewind(src, opt) != 0) return -1;
+    src->num_traces = trace_stream_num_traces(src->stream);
+    src->trace_length = trace_stream_trace_length(src->stream);
+    printf("Streaming %zu traces from %s (%s)\n", src->num_traces, opt->input,
+           trace_stream_backend(src->stream));
+    return 0;
+}
+
+static void source_close(BatchSource *src) {
+    trace_stream_close(src->stream);
+    src->stream = NULL;
+}
+
+// Up to `max` traces. Return the count, 0 at the end, or -1 on error.
+static long source_next(BatchSource *src, size_t max, TraceSet *batch) {
+    if (src->set) {
+        size_t count = src->num_traces - src->pos;
+        if (count > max) count = max;
+        *batch = subset_view(src->set, src->pos, count);
+        src->pos += count;
+        return (long)count;
+    }
+    if (src->pending.num_traces == 0) {
+        long got = trace_stream_next(src->stream, &src->pending);
+        if (got <= 0) return got;
+    }
+    size_t count = src->pending.num_traces < max ? src->pending.num_traces : max;
+    *batch = src->pending;
+    batch->num_traces = count;
+    src->pending = subset_view(&src->pending, count, src->pending.num_traces - count);
+    src->pos += count;
+    return (long)count;
+}
+
+static int rank_of(const float *score, int guess) {
+    int rank = 1;
+    for (int g = 0; g < 256; g++) {
+        if (score[g] > score[guess]) rank++;
+    }
+    return rank;
+}
+
+// The attacks rank one true key, so every trace must carry the key of trace
+// `key_index`. `first` is the index of batch row 0. Return 0 or -1.
+static int check_key(const TraceSet *batch, size_t first, const uint8_t *key, size_t key_index) {
+    for (size_t t = 0; t < batch->num_traces; t++) {
+        if (memcmp(batch->keys[t], key, 16) != 0) {
+            printf("Error: Trace %zu does not share the key of trace %zu; attack a fixed-key set\n",
+                   first + t, key_index);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void print_top(const float *score, int count) {
+    int used[256] = { 0 };
+    for (int r = 0; r < count; r++) {
+        int best = -1;
+        for (int g = 0; g < 256; g++) {
+            if (!used[g] && (best < 0 || score[g] > score[best])) best = g;
+        }
+        used[best] = 1;
+        printf("  #%d  guess 0x%02x  score %.5f\n", r + 1, best, score[best]);
+    }
+}
+
+static int run_cpa2(const AttackOptions *opt, const TraceSet *set) {
+    BatchSource src;
+    if (source_open(&src, opt, set) != 0) return -1;
+
+    Cpa2Config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.start = opt->start;
+    cfg.end = opt->end > 0 ? opt->end : src.trace_length;
+    cfg.window = opt->window;
+    cfg.byte = opt->byte;
+    cfg.target = opt->target;
+    cfg.model = opt->model;
+    cfg.threads = opt->threads;
+
+    Cpa2 *cpa = cpa2_create(&cfg, src.trace_length);
+    if (!cpa) {
+        source_close(&src);
+        return -1;
+    }
+
+    // Two passes over the traces: means first, then the centered products
+    TraceSet batch;
+    uint8_t key[16];
+    long got = 0;
+    for (int pass = 0; pass < 2 && got >= 0; pass++) {
+        if (pass == 1 && source_rewind(&src, opt) != 0) got = -1;
+        while (got >= 0 && (got = source_next(&src, SIZE_MAX, &batch)) > 0) {
+            if (pass == 0) {
+                if (src.pos == (size_t)got) memcpy(key, batch.keys[0], 16);
+                if (check_key(&batch, src.pos - (size_t)got, key, 0) != 0) {
+                    got = -1;
+                    break;
+                }
+                cpa2_add_mean(cpa, &batch);
+            } else {
+                cpa2_add(cpa, &batch);
+            }
+        }
+    }
+    source_close(&src);
+    if (got < 0) {
+        cpa2_free(cpa);
+        return -1;
+    }
+
+    Cpa2Result res;
+    cpa2_result(cpa, &res);
+    cpa2_free(cpa);
+
+    uint8_t true_subkey = leakage_true_subkey(opt->target, key, opt->byte);
+    printf("=== Second-order CPA, byte %d, samples [%d, %d), window %d, %zu traces ===\n",
+           opt->byte, cfg.start, cfg.end, cfg.window, res.num_traces);
+    print_top(res.peak, 5);
+    printf("Best guess 0x%02x at samples (%d, %d)\n", res.best_guess,
+           res.peak_i[res.best_guess], res.peak_j[res.best_guess]);
+    printf("True subkey 0x%02x: rank %d, score %.5f\n", true_subkey,
+           rank_of(res.peak, true_subkey), res.peak[true_subkey]);
+    return 0;
+}
+
+// Reduce the traces exactly like the profiling set the reduction was fitted on
+static int run_poi_apply(const AttackOptions *opt, const TraceSet *set) {
+    PoiReduction red;
+    if (poi_reduction_load(opt->reduction, &red) != 0) return -1;
+
+    printf("=== Saved reduction %s: %d samples -> %d %s ===\n", opt->reduction, red.input_length,
+           red.output_length, red.idx ? "selected samples" : "PCA components");
+    TraceSet reduced;
+    memset(&reduced, 0, sizeof(reduced));
+    int rc = poi_reduction_apply(&red, set, &reduced, opt->threads);
+    if (rc == 0 && opt->output) {
+        rc = trace_store_save(opt->output, &reduced);
+        if (rc == 0) {
+            printf("Reduced traces: %zu x %d -> %s\n", reduced.num_traces, reduced.trace_length,
+                   opt->output);
+        }
+    }
+    trace_set_free(&reduced);
+    poi_reduction_free(&red);
+    return rc;
+}
+
+// The reduction goes next to the reduced traces, as OUTPUT.red
+static int save_reduction(const AttackOptions *opt, const PoiReduction *red) {
+    char name[1024];
+    snprintf(name, sizeof(name), "%s.red", opt->output);
+    if (poi_reduction_save(red, name) != 0) return -1;
+    printf("Reduction: %d samples -> %d -> %s\n", red->input_length, red->output_length, name);
+    return 0;
+}
+
+static int run_poi(const AttackOptions *opt, const TraceSet *set) {
+    if (opt->reduction) return run_poi_apply(opt, set);
+
+    PoiConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.byte = opt->byte;
+    cfg.target = opt->target;
+    cfg.hw_classes = opt->hw_classes;
+    cfg.threads = opt->threads;
+
+    PoiStats *stats = poi_stats_create(&cfg, set->trace_length);
+    if (!stats) return -1;
+    if (poi_stats_add(stats, set) != 0) {
+        poi_stats_free(stats);
+        return -1;
+    }
+
+    float *score = malloc((size_t)set->trace_length * sizeof(float));
+    int *idx = malloc((size_t)set->trace_length * sizeof(int));
+    if (!score || !idx) {
+        free(score);
+        free(idx);
+        poi_stats_free(stats);
+        return -1;
+    }
+    poi_score(stats, opt->metric, score);
+    int k = opt->poi_count < set->trace_length ? opt->poi_count : set->trace_length;
+    k = poi_select_top(score, set->trace_length, k, opt->min_distance, idx);
+
+    printf("=== Points of interest (%s), byte %d, %d classes, %zu traces ===\n",
+           opt->metric == POI_SOST ? "SOST" : "SNR", opt->byte, poi_num_classes(stats),
+           set->num_traces);
+    for (int i = 0; i < k; i++) printf("  #%-3d sample %4d  score %.5f\n", i + 1, idx[i], score[idx[i]]);
+
+    int rc = 0;
+    PoiReduction red;
+    memset(&red, 0, sizeof(red));
+    if (opt->pca_components > 0) {
+        PoiPca pca;
+        rc = poi_pca_build(stats, opt->pca_components, &pca);
+        if (rc == 0) {
+            printf("PCA: %d components, explained variance", pca.components);
+            for (int c = 0; c < pca.components && c < 8; c++) printf(" %.3g", pca.variance[c]);
+            printf("%s\n", pca.components > 8 ? " ..." : "");
+            poi_reduction_from_pca(&pca, &red);
+        } else {
+            printf("Error: Not enough classes for PCA\n");
+        }
+    } else if (opt->output) {
+        rc = poi_reduction_from_select(idx, k, set->trace_length, &red);
+    }
+
+    TraceSet reduced;
+    memset(&reduced, 0, sizeof(reduced));
+    if (rc == 0 && opt->output) {
+        rc = poi_reduction_apply(&red, set, &reduced, opt->threads);
+        if (rc == 0) rc = trace_store_save(opt->output, &reduced);
+        if (rc == 0) {
+            printf("Reduced traces: %zu x %d -> %s\n", reduced.num_traces, reduced.trace_length,
+                   opt->output);
+            rc = save_reduction(opt, &red);
+        }
+    }
+
+    trace_set_free(&reduced);
+    poi_reduction_free(&red);
+    free(score);
+    free(idx);
+    poi_stats_free(stats);
+    return rc;
+}
+
+// Profiling on known keys: POIs by SNR (all samples if the set is already reduced).
+// `red` is the --reduction the set went through, recorded in the template.
+static int run_template_build(const AttackOptions *opt, const TraceSet *set,
+                              const PoiReduction *red) {
+    if (!opt->output) {
+        printf("Error: template-build needs -o TEMPLATE_FILE\n");
+        return -1;
+    }
+
+    PoiConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.byte = opt->byte;
+    cfg.target = opt->target;
+    cfg.hw_classes = opt->hw_classes;
+    cfg.threads = opt->threads;
+
+    int *idx = malloc((size_t)set->trace_length * sizeof(int));
+    if (!idx) return -1;
+    int k;
+    if (set->trace_length <= opt->poi_count) {
+        k = set->trace_length;
+        for (int i = 0; i < k; i++) idx[i] = i;
+    } else {
+        PoiStats *stats = poi_stats_create(&cfg, set->trace_length);
+        float *score = malloc((size_t)set->trace_length * sizeof(float));
+        if (!stats || !score) {
+            poi_stats_free(stats);
+            free(score);
+            free(idx);
+            return -1;
+        }
+        if (poi_stats_add(stats, set) != 0) {
+            poi_stats_free(stats);
+            free(score);
+            free(idx);
+            return -1;
+        }
+        poi_score(stats, opt->metric, score);
+        k = poi_select_top(score, set->trace_length, opt->poi_count, opt->min_distance, idx);
+        free(score);
+        poi_stats_free(stats);
+    }
+
+    Template tpl;
+    int rc = template_build(&cfg, set, idx, k, red, &tpl);
+    if (rc == 0) {
+        rc = template_save(&tpl, opt->output);
+        if (rc == 0) {
+            printf("Templates: byte %d, %d classes, %d POIs, %zu profiling traces -> %s\n",
+                   opt->byte, tpl.classes, tpl.num_poi, set->num_traces, opt->output);
+        }
+        template_free(&tpl);
+    }
+    free(idx);
+    return rc;
+}
+
+static int run_template(const AttackOptions *opt, const TraceSet *set) {
+    if (!opt->template_file) {
+        printf("Error: template attack needs --template FILE\n");
+        return -1;
+    }
+    if (check_key(set, 0, set->keys[0], 0) != 0) return -1;
+    Template tpl;
+    if (template_load(opt->template_file, &tpl) != 0) return -1;
+
+    TemplateScores scores;
+    template_scores_reset(&scores);
+    if (template_attack(&tpl, set, &scores, opt->threads) != 0) {
+        template_free(&tpl);
+        return -1;
+    }
+
+    // Print log-likelihoods relative to the best guess
+    double best = scores.loglik[0];
+    for (int g = 1; g < 256; g++) {
+        if (scores.loglik[g] > best) best = scores.loglik[g];
+    }
+    float rel[256];
+    for (int g = 0; g < 256; g++) rel[g] = (float)(scores.loglik[g] - best);
+
+    uint8_t true_subkey = leakage_true_subkey(tpl.cls.target, set->keys[0], tpl.cls.byte);
+    printf("=== Template attack, byte %d, %d POIs, %zu traces ===\n", tpl.cls.byte, tpl.num_poi,
+           scores.num_traces);
+    print_top(rel, 5);
+    printf("True subkey 0x%02x: rank %d, log-likelihood %.3f\n", true_subkey,
+           rank_of(rel, true_subkey), rel[true_subkey]);
+
+    template_free(&tpl);
+    return 0;
+}
+
+// Evaluation curves: after every `step` traces the per-byte scores are turned
+// into log2 probabilities, the true subkey ranks feed guessing entropy and
+// success rate, and the full key rank is estimated. Scores are accumulated
+// incrementally, so each experiment is a single pass over its traces.
+static int run_rank(const AttackOptions *opt, const TraceSet *set) {
+    Template tpl[16];
+    int have_tpl[16] = { 0 };
+    int attacked = 16;
+    LeakTarget target = opt->target;
+    if (opt->template_file) {
+        attacked = 0;
+        int per_byte = strstr(opt->template_file, "%d") != NULL;
+        for (int b = 0; b < (per_byte ? 16 : 1); b++) {
+            char name[1024];
+            if (per_byte) {
+                snprintf(name, sizeof(name), opt->template_file, b);
+            } else {
+                snprintf(name, sizeof(name), "%s", opt->template_file);
+            }
+            Template t;
+            if (template_load(name, &t) != 0) continue;
+            if (have_tpl[t.cls.byte]) {
+                template_free(&t);
+                continue;
+            }
+            tpl[t.cls.byte] = t;
+            have_tpl[t.cls.byte] = 1;
+            target = t.cls.target;
+            attacked++;
+        }
+        if (attacked == 0) return -1;
+    }
+
+    BatchSource src;
+    size_t per = 0, points = 0;
+    double *sum_ge = NULL, *sum_sr = NULL, *sum_log2 = NULL;
+    int rc = source_open(&src, opt, set);
+    if (rc == 0) {
+        per = src.num_traces / (size_t)opt->experiments;
+        if (per == 0 || opt->step == 0) {
+            printf("Error: Not enough traces for %d experiments\n", opt->experiments);
+            rc = -1;
+        }
+        points = per ? (per + opt->step - 1) / opt->step : 0;
+    }
+    if (rc == 0) {
+        sum_ge = calloc(points, sizeof(double));
+        sum_sr = calloc(points, sizeof(double));
+        sum_log2 = calloc(3 * points, sizeof(double));
+        if (!sum_ge || !sum_sr || !sum_log2) rc = -1;
+    }
+
+    double loglik[16][256];
+    double log2p[16][256];
+    float peak[16][256];
+    for (int e = 0; e < opt->experiments && rc == 0; e++) {
+        uint8_t full_key[16], key[16];
+        Cpa *cpa = NULL;
+        TemplateScores scores[16];
+        if (!opt->template_file) {
+            CpaConfig cfg;
+            memset(&cfg, 0, sizeof(cfg));
+            cfg.start = opt->start;
+            cfg.end = opt->end > 0 ? opt->end : src.trace_length;
+            cfg.target = opt->target;
+            cfg.model = opt->model;
+            cfg.threads = opt->threads;
+            cpa = cpa_create(&cfg, src.trace_length);
+            if (!cpa) {
+                rc = -1;
+                break;
+            }
+        }
+        for (int b = 0; b < 16; b++) template_scores_reset(&scores[b]);
+
+        for (size_t p = 0; p < points; p++) {
+            size_t first = p * opt->step;
+            size_t count = per - first < opt->step ? per - first : opt->step;
+            for (size_t need = count; need > 0 && rc == 0;) {
+                TraceSet batch;
+                long got = source_next(&src, need, &batch);
+                if (got <= 0) {
+                    rc = -1;
+                    break;
+                }
+                size_t at = src.pos - (size_t)got;
+                if (first == 0 && need == count) {
+                    memcpy(full_key, batch.keys[0], 16);
+                    for (int b = 0; b < 16; b++) key[b] = leakage_true_subkey(target, full_key, b);
+                }
+                if (check_key(&batch, at, full_key, (size_t)e * per) != 0) {
+                    rc = -1;
+                    break;
+                }
+                if (cpa) {
+                    cpa_add(cpa, &batch);
+                } else {
+                    for (int b = 0; b < 16 && rc == 0; b++) {
+                        if (!have_tpl[b]) continue;
+                        rc = template_attack(&tpl[b], &batch, &scores[b], opt->threads);
+                    }
+                }
+                need -= (size_t)got;
+            }
+            if (rc != 0) break;
+
+            if (cpa) {
+                cpa_peaks(cpa, peak);
+                for (int b = 0; b < 16; b++) key_rank_cpa_loglik(peak[b], first + count, loglik[b]);
+            } else {
+                // Bytes without a template stay uniform
+                for (int b = 0; b < 16; b++) memcpy(loglik[b], scores[b].loglik, sizeof(loglik[b]));
+            }
+
+            int ranked_first = 0;
+            double rank_sum = 0.0;
+            for (int b = 0; b < 16; b++) {
+                key_rank_log2_probs(loglik[b], log2p[b]);
+                if (cpa || have_tpl[b]) {
+                    int r = key_rank_byte(log2p[b], key[b]);
+                    rank_sum += r;
+                    ranked_first += r == 1;
+                }
+            }
+            KeyRankEstimate est;
+            if (key_rank_estimate(log2p, key, opt->bins, &est) != 0) {
+                printf("Error: Key rank estimation failed\n");
+                rc = -1;
+                break;
+            }
+            sum_ge[p] += rank_sum / attacked;
+            sum_sr[p] += (double)ranked_first / attacked;
+            sum_log2[3 * p] += est.log2_rank;
+            sum_log2[3 * p + 1] += est.log2_lower;
+            sum_log2[3 * p + 2] += est.log2_upper;
+        }
+        cpa_free(cpa);
+    }
+
+    if (rc == 0) {
+        printf("=== Key rank (%s), %d experiment(s) of %zu traces, %d byte(s) attacked ===\n",
+               opt->template_file ? "templates" : "CPA", opt->experiments, per, attacked);
+        printf("  traces   byte GE   byte SR   log2 key rank [lower, upper]\n");
+        for (size_t p = 0; p < points; p++) {
+            size_t traces = (p + 1) * opt->step < per ? (p + 1) * opt->step : per;
+            double k = (double)opt->experiments;
+            printf("  %7zu  %8.2f  %8.3f   %6.1f [%.1f, %.1f]\n", traces, sum_ge[p] / k,
+                   sum_sr[p] / k, sum_log2[3 * p] / k, sum_log2[3 * p + 1] / k,
+                   sum_log2[3 * p + 2] / k);
+        }
+    }
+
+    source_close(&src);
+    for (int b = 0; b < 16; b++) {
+        if (have_tpl[b]) template_free(&tpl[b]);
+    }
+    free(sum_ge);
+    free(sum_sr);
+    free(sum_log2);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    enum { OPT_TARGET = 256, OPT_MODEL, OPT_START, OPT_END, OPT_WINDOW, OPT_METRIC,
+           OPT_MIN_DISTANCE, OPT_PCA, OPT_HW_CLASSES, OPT_TEMPLATE, OPT_STEP,
+           OPT_EXPERIMENTS, OPT_BINS, OPT_STREAM, OPT_REDUCTION };
+    static const struct option options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "traces", required_argument, NULL, 'n' },
+        { "length", required_argument, NULL, 'l' },
+        { "threads", required_argument, NULL, 't' },
+        { "byte", required_argument, NULL, 'b' },
+        { "target", required_argument, NULL, OPT_TARGET },
+        { "model", required_argument, NULL, OPT_MODEL },
+        { "start", required_argument, NULL, OPT_START },
+        { "end", required_argument, NULL, OPT_END },
+        { "window", required_argument, NULL, OPT_WINDOW },
+        { "metric", required_argument, NULL, OPT_METRIC },
+        { "poi", required_argument, NULL, 'k' },
+        { "min-distance", required_argument, NULL, OPT_MIN_DISTANCE },
+        { "pca", required_argument, NULL, OPT_PCA },
+        { "hw-classes", no_argument, NULL, OPT_HW_CLASSES },
+        { "output", required_argument, NULL, 'o' },
+        { "template", required_argument, NULL, OPT_TEMPLATE },
+        { "reduction", required_argument, NULL, OPT_REDUCTION },
+        { "step", required_argument, NULL, OPT_STEP },
+        { "experiments", required_argument, NULL, OPT_EXPERIMENTS },
+        { "bins", required_argument, NULL, OPT_BINS },
+        { "stream", no_argument, NULL, OPT_STREAM },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    AttackOptions opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.mode = "cpa2";
+    opt.csv_length = TRACE_LENGTH;
+    opt.window = 16;
+    opt.poi_count = 20;
+    opt.min_distance = 1;
+    opt.step = 100;
+    opt.experiments = 1;
+    opt.bins = KEY_RANK_DEFAULT_BINS;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "m:n:l:t:b:k:o:h", options, NULL)) != -1) {
+        switch (c) {
+        case 'm': opt.mode = optarg; break;
+        case 'n': opt.max_traces = strtoull(optarg, NULL, 10); break;
+        case 'l': opt.csv_length = atoi(optarg); break;
+        case 't': opt.threads = atoi(optarg); break;
+        case 'b': opt.byte = atoi(optarg); break;
+        case OPT_TARGET:
+            if (leakage_parse_target(optarg, &opt.target) != 0) {
+                printf("Error: Unknown target '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case OPT_MODEL:
+            if (leakage_parse_model(optarg, &opt.model) != 0) {
+                printf("Error: Unknown model '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case OPT_START: opt.start = atoi(optarg); break;
+        case OPT_END: opt.end = atoi(optarg); break;
+        case OPT_WINDOW: opt.window = atoi(optarg); break;
+        case OPT_METRIC:
+            if (strcmp(optarg, "snr") == 0) {
+                opt.metric = POI_SNR;
+            } else if (strcmp(optarg, "sost") == 0) {
+                opt.metric = POI_SOST;
+            } else {
+                printf("Error: Unknown metric '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'k': opt.poi_count = atoi(optarg); break;
+        case OPT_MIN_DISTANCE: opt.min_distance = atoi(optarg); break;
+        case OPT_PCA: opt.pca_components = atoi(optarg); break;
+        case OPT_HW_CLASSES: opt.hw_classes = 1; break;
+        case 'o': opt.output = optarg; break;
+        case OPT_TEMPLATE: opt.template_file = optarg; break;
+        case OPT_REDUCTION: opt.reduction = optarg; break;
+        case OPT_STEP: opt.step = strtoull(optarg, NULL, 10); break;
+        case OPT_EXPERIMENTS: opt.experiments = atoi(optarg); break;
+        case OPT_BINS: opt.bins = atoi(optarg); break;
+        case OPT_STREAM: opt.stream = 1; break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    opt.input = argv[optind];
+    if (opt.byte < 0 || opt.byte > 15) {
+        printf("Error: Key byte must be 0..15\n");
+        return 1;
+    }
+    if (opt.experiments < 1) {
+        printf("Error: Need at least one experiment\n");
+        return 1;
+    }
+
+    if (opt.stream && strcmp(opt.mode, "cpa2") != 0 && strcmp(opt.mode, "rank") != 0) {
+        printf("Error: --stream is only supported by the cpa2 and rank modes\n");
+        return 1;
+    }
+    if (opt.reduction && (opt.stream || strcmp(opt.mode, "cpa2") == 0)) {
+        printf("Error: --reduction needs a poi or template mode with the traces in memory\n");
+        return 1;
+    }
+
+    // Streaming modes read the file themselves, with the read-ahead included in the timing
+    TraceSet set;
+    memset(&set, 0, sizeof(set));
+    if (!opt.stream && load_traces(&opt, &set) <= 0) {
+        printf("Error: No traces loaded from %s\n", opt.input);
+        return 1;
+    }
+
+    PoiReduction red;
+    memset(&red, 0, sizeof(red));
+    if (opt.reduction && strcmp(opt.mode, "poi") != 0 && reduce_input(&opt, &set, &red) != 0) {
+        poi_reduction_free(&red);
+        trace_set_free(&set);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int rc;
+    if (strcmp(opt.mode, "cpa2") == 0) {
+        rc = run_cpa2(&opt, &set);
+    } else if (strcmp(opt.mode, "poi") == 0) {
+        rc = run_poi(&opt, &set);
+    } else if (strcmp(opt.mode, "template-build") == 0) {
+        rc = run_template_build(&opt, &set, opt.reduction ? &red : NULL);
+    } else if (strcmp(opt.mode, "template") == 0) {
+        rc = run_template(&opt, &set);
+    } else if (strcmp(opt.mode, "rank") == 0) {
+        rc = run_rank(&opt, &set);
+    } else {
+        printf("Error: Unknown mode '%s'\n", opt.mode);
+        rc = -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (rc == 0) {
+        printf("Analysis time: %.2f s\n",
+               (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+    }
+    poi_reduction_free(&red);
+    trace_set_free(&set);
+    return rc == 0 ? 0 : 1;
+}
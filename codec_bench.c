@@ -0,0 +1,173 @@
+// Created by Team "RTL Rangers"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "sca_config.h"
+#include "trace_codec.h"
+#include "trace_gen.h"
+
+// Reports compression ratio and decode throughput of the packed trace codec.
+//   codec_bench [traces.bin|-] [num_traces] [repeats] [threads] [q|adc]
+// With "-" (default) the traces come from the synthetic generator.
+// "q" (default) quantizes the float samples to Qm.n; "adc" first digitizes
+// them like an 8-bit ADC over their range and packs the ADC codes, which
+// must decode losslessly.
+
+#define ADC_LEVELS 256
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    const char *input = argc > 1 ? argv[1] : "-";
+    size_t num_traces = argc > 2 ? strtoull(argv[2], NULL, 10) : 20000;
+    int repeats = argc > 3 ? atoi(argv[3]) : 10;
+    int threads = argc > 4 ? atoi(argv[4]) : 0;
+    int adc = argc > 5 && strcmp(argv[5], "adc") == 0;
+
+    // Scratch file, so an existing file in the working directory is never touched
+    const char *tmpdir = getenv("TMPDIR");
+    char packed_path[1024];
+    snprintf(packed_path, sizeof(packed_path), "%s/codec_bench.XXXXXX", tmpdir ? tmpdir : "/tmp");
+    int tmp_fd = mkstemp(packed_path);
+    if (tmp_fd < 0) {
+        printf("Error: Cannot create a scratch file in %s\n", tmpdir ? tmpdir : "/tmp");
+        return 1;
+    }
+    close(tmp_fd);
+
+    TraceSet set;
+    if (strcmp(input, "-") == 0) {
+        TraceGenConfig cfg;
+        trace_gen_default_config(&cfg);
+        cfg.num_traces = num_traces;
+        cfg.threads = threads;
+        if (trace_set_alloc(&set, num_traces, cfg.trace_length) != 0) {
+            printf("Error: Out of memory\n");
+            return 1;
+        }
+        trace_gen_fill(&cfg, &set, 0, num_traces);
+    } else if (trace_store_load(input, &set, num_traces) < 0) {
+        unlink(packed_path);
+        return 1;
+    }
+
+    size_t samples = set.num_traces * (size_t)set.trace_length;
+    int16_t *codes = NULL;
+    float step = 1.0f / (1 << FIXED_N);
+    uint64_t saturated = 0;
+    if (adc) {
+        float lo = set.traces[0], hi = set.traces[0];
+        for (size_t i = 1; i < samples; i++) {
+            if (set.traces[i] < lo) lo = set.traces[i];
+            if (set.traces[i] > hi) hi = set.traces[i];
+        }
+        float mid = 0.5f * (lo + hi);
+        step = hi > lo ? (hi - lo) / (ADC_LEVELS - 1) : 1.0f;
+        codes = malloc(samples * sizeof(int16_t));
+        if (!codes) {
+            printf("Error: Out of memory\n");
+            unlink(packed_path);
+            return 1;
+        }
+        for (size_t i = 0; i < samples; i++) {
+            long c = lrintf((set.traces[i] - mid) / step);
+            if (c < -ADC_LEVELS / 2 || c > ADC_LEVELS / 2 - 1) {
+                c = c < 0 ? -ADC_LEVELS / 2 : ADC_LEVELS / 2 - 1;
+                saturated++;
+            }
+            codes[i] = (int16_t)c;
+            set.traces[i] -= mid;   // the codes carry no DC offset
+        }
+    }
+
+    double t0 = now_seconds();
+    int rc = adc ? trace_codec_write_int16(packed_path, &set, codes, step, threads)
+                 : trace_codec_write_quantized(packed_path, &set, FIXED_M, FIXED_N, threads,
+                                               &saturated);
+    double encode_secs = now_seconds() - t0;
+    if (rc != 0) {
+        unlink(packed_path);
+        return 1;
+    }
+
+    int fd = open(packed_path, O_RDONLY);
+    unlink(packed_path);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Error: Cannot reopen %s\n", packed_path);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t *image = malloc(size);
+    if (!image || pread(fd, image, size, 0) != (ssize_t)size) {
+        printf("Error: Cannot read %s\n", packed_path);
+        return 1;
+    }
+    close(fd);
+
+    TraceFileHeader hdr;
+    memcpy(&hdr, image, sizeof(hdr));
+
+    TraceSet decoded;
+    if (trace_set_alloc(&decoded, set.num_traces, set.trace_length) != 0) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+
+    // Warm-up pass also faults in the output pages
+    if (trace_codec_decode(image, size, &hdr, &decoded, threads) != 0) {
+        printf("Error: Decode failed\n");
+        return 1;
+    }
+    t0 = now_seconds();
+    for (int r = 0; r < repeats; r++) trace_codec_decode(image, size, &hdr, &decoded, threads);
+    double decode_secs = (now_seconds() - t0) / (repeats > 0 ? repeats : 1);
+
+    float max_err = 0.0f;
+    size_t code_mismatch = 0;
+    for (size_t i = 0; i < samples; i++) {
+        float err = fabsf(decoded.traces[i] - set.traces[i]);
+        if (err > max_err) max_err = err;
+        if (codes && decoded.traces[i] != (float)codes[i] * step) code_mismatch++;
+    }
+    int meta_ok = memcmp(decoded.keys, set.keys, set.num_traces * 16) == 0 &&
+                  memcmp(decoded.plaintexts, set.plaintexts, set.num_traces * 16) == 0;
+
+    double raw_bytes = (double)set.num_traces * trace_record_size(set.trace_length);
+    double float_bytes = (double)samples * sizeof(float);
+
+    if (adc) {
+        printf("=== Packed trace codec (8-bit ADC codes) ===\n");
+    } else {
+        printf("=== Packed trace codec (Q%d.%d) ===\n", FIXED_M, FIXED_N);
+    }
+    printf("Traces            : %zu x %d samples\n", set.num_traces, set.trace_length);
+    printf("Raw F32 size      : %.1f MB\n", raw_bytes / 1e6);
+    printf("Packed size       : %.1f MB\n", size / 1e6);
+    printf("Compression ratio : %.2fx\n", raw_bytes / size);
+    printf("Encode            : %.2f GB/s of float samples\n", float_bytes / encode_secs / 1e9);
+    printf("Decode            : %.2f GB/s of float samples (%.2f GB/s packed input)\n",
+           float_bytes / decode_secs / 1e9, size / decode_secs / 1e9);
+    printf("Max abs error     : %.6f (step %.6f)\n", max_err, step);
+    printf("Saturated samples : %llu (%.3f%%)\n", (unsigned long long)saturated,
+           samples ? 100.0 * (double)saturated / (double)samples : 0.0);
+    if (adc) printf("ADC codes intact  : %s\n", code_mismatch == 0 ? "yes" : "NO");
+    printf("Metadata intact   : %s\n", meta_ok ? "yes" : "NO");
+
+    trace_set_free(&decoded);
+    trace_set_free(&set);
+    free(image);
+    free(codes);
+    return meta_ok && code_mismatch == 0 ? 0 : 1;
+}
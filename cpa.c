@@ -0,0 +1,179 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpa.h"
+#include "parallel.h"
+
+#define CPA_BATCH 128
+#define CPA_TILE 256
+
+struct Cpa {
+    CpaConfig cfg;
+    int region;             // end - start
+    int tiles;              // column tiles per byte
+    int threads;
+
+    size_t n;
+    double sum_h[16][256];
+    double sum_h2[16][256];
+    double *sum_x;          // [region]
+    double *sum_x2;         // [region]
+    double *sum_hx;         // [16][256][region]
+
+    // Per batch scratch
+    float *hyp;             // [16][256][CPA_BATCH]
+    const float *rows[CPA_BATCH];
+};
+
+Cpa *cpa_create(const CpaConfig *cfg, int trace_length) {
+    if (cfg->start < 0 || cfg->end > trace_length || cfg->end <= cfg->start) {
+        printf("Error: Invalid CPA region\n");
+        return NULL;
+    }
+
+    Cpa *cpa = calloc(1, sizeof(Cpa));
+    if (!cpa) return NULL;
+    cpa->cfg = *cfg;
+    cpa->region = cfg->end - cfg->start;
+    cpa->tiles = (cpa->region + CPA_TILE - 1) / CPA_TILE;
+    cpa->threads = cfg->threads > 0 ? cfg->threads : parallel_default_threads();
+
+    cpa->sum_x = calloc((size_t)cpa->region, sizeof(double));
+    cpa->sum_x2 = calloc((size_t)cpa->region, sizeof(double));
+    cpa->sum_hx = calloc(16 * 256 * (size_t)cpa->region, sizeof(double));
+    cpa->hyp = malloc(16 * 256 * CPA_BATCH * sizeof(float));
+    if (!cpa->sum_x || !cpa->sum_x2 || !cpa->sum_hx || !cpa->hyp) {
+        printf("Error: Out of memory for CPA on %d samples\n", cpa->region);
+        cpa_free(cpa);
+        return NULL;
+    }
+    return cpa;
+}
+
+void cpa_free(Cpa *cpa) {
+    if (!cpa) return;
+    free(cpa->sum_x);
+    free(cpa->sum_x2);
+    free(cpa->sum_hx);
+    free(cpa->hyp);
+    free(cpa);
+}
+
+size_t cpa_num_traces(const Cpa *cpa) {
+    return cpa->n;
+}
+
+typedef struct {
+    Cpa *cpa;
+    const TraceSet *set;
+    size_t first;
+    size_t rows;
+} BatchTask;
+
+static void hyp_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    BatchTask *task = (BatchTask *)ctx;
+    Cpa *cpa = task->cpa;
+    const TraceSet *set = task->set;
+
+    for (size_t byte = begin; byte < end; byte++) {
+        for (int g = 0; g < 256; g++) {
+            float *h = cpa->hyp + (byte * 256 + (size_t)g) * CPA_BATCH;
+            double sh = 0.0, sh2 = 0.0;
+            for (size_t b = 0; b < task->rows; b++) {
+                size_t t = task->first + b;
+                int v = leakage_hypothesis(cpa->cfg.target, cpa->cfg.model, set->plaintexts[t],
+                                           set->ciphertexts[t], (int)byte, (uint8_t)g);
+                h[b] = (float)v;
+                sh += v;
+                sh2 += v * v;
+            }
+            cpa->sum_h[byte][g] += sh;
+            cpa->sum_h2[byte][g] += sh2;
+        }
+    }
+}
+
+// One task per (byte, column tile): hypotheses (256 x rows) times samples (rows x tile)
+static void tile_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    BatchTask *task = (BatchTask *)ctx;
+    Cpa *cpa = task->cpa;
+    const size_t rows = task->rows;
+    const int region = cpa->region;
+    float acc[CPA_TILE];
+
+    for (size_t idx = begin; idx < end; idx++) {
+        size_t byte = idx / (size_t)cpa->tiles;
+        int s0 = (int)(idx % (size_t)cpa->tiles) * CPA_TILE;
+        int ns = region - s0 < CPA_TILE ? region - s0 : CPA_TILE;
+
+        if (byte == 0) {
+            float acc2[CPA_TILE];
+            for (int s = 0; s < ns; s++) acc[s] = acc2[s] = 0.0f;
+            for (size_t b = 0; b < rows; b++) {
+                const float *x = cpa->rows[b] + s0;
+                for (int s = 0; s < ns; s++) {
+                    acc[s] += x[s];
+                    acc2[s] += x[s] * x[s];
+                }
+            }
+            for (int s = 0; s < ns; s++) {
+                cpa->sum_x[s0 + s] += acc[s];
+                cpa->sum_x2[s0 + s] += acc2[s];
+            }
+        }
+
+        for (int g = 0; g < 256; g++) {
+            const float *h = cpa->hyp + (byte * 256 + (size_t)g) * CPA_BATCH;
+            for (int s = 0; s < ns; s++) acc[s] = 0.0f;
+            for (size_t b = 0; b < rows; b++) {
+                const float hb = h[b];
+                const float *x = cpa->rows[b] + s0;
+                for (int s = 0; s < ns; s++) acc[s] += hb * x[s];
+            }
+            double *shx = cpa->sum_hx + (byte * 256 + (size_t)g) * region + s0;
+            for (int s = 0; s < ns; s++) shx[s] += acc[s];
+        }
+    }
+}
+
+void cpa_add(Cpa *cpa, const TraceSet *batch) {
+    for (size_t first = 0; first < batch->num_traces; first += CPA_BATCH) {
+        size_t rows = batch->num_traces - first;
+        if (rows > CPA_BATCH) rows = CPA_BATCH;
+        for (size_t b = 0; b < rows; b++) {
+            cpa->rows[b] = trace_set_row(batch, first + b) + cpa->cfg.start;
+        }
+
+        BatchTask task = { cpa, batch, first, rows };
+        parallel_for(16, cpa->threads, hyp_worker, &task);
+        parallel_for(16 * (size_t)cpa->tiles, cpa->threads, tile_worker, &task);
+        cpa->n += rows;
+    }
+}
+
+void cpa_peaks(const Cpa *cpa, float peak[16][256]) {
+    const double n = (double)cpa->n;
+    const int region = cpa->region;
+
+    for (int byte = 0; byte < 16; byte++) {
+        for (int g = 0; g < 256; g++) {
+            double sh = cpa->sum_h[byte][g];
+            double vh = n * cpa->sum_h2[byte][g] - sh * sh;
+            const double *shx = cpa->sum_hx + ((size_t)byte * 256 + (size_t)g) * region;
+            float best = 0.0f;
+
+            for (int s = 0; s < region && vh > 0.0; s++) {
+                double vx = n * cpa->sum_x2[s] - cpa->sum_x[s] * cpa->sum_x[s];
+                if (vx <= 0.0) continue;
+                float r = (float)fabs((n * shx[s] - sh * cpa->sum_x[s]) / sqrt(vh * vx));
+                if (r > best) best = r;
+            }
+            peak[byte][g] = best;
+        }
+    }
+}
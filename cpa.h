@@ -0,0 +1,34 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _CPA_H_
+#define _CPA_H_
+
+#include <stddef.h>
+#include "leakage.h"
+#include "trace_store.h"
+
+// Incremental first-order CPA on all 16 key bytes at once. Only running sums
+// are kept, so correlations can be read after every batch without
+// re-processing earlier traces.
+typedef struct {
+    int start;          // analysed samples [start, end)
+    int end;
+    LeakTarget target;
+    LeakModel model;
+    int threads;        // 0 = all online CPUs
+} CpaConfig;
+
+typedef struct Cpa Cpa;
+
+// Return NULL on invalid config or allocation failure.
+Cpa *cpa_create(const CpaConfig *cfg, int trace_length);
+void cpa_free(Cpa *cpa);
+
+void cpa_add(Cpa *cpa, const TraceSet *batch);
+
+size_t cpa_num_traces(const Cpa *cpa);
+
+// Max |correlation| over the analysed samples for every byte and guess
+void cpa_peaks(const Cpa *cpa, float peak[16][256]);
+
+#endif // _CPA_H_
@@ -0,0 +1,276 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpa2.h"
+#include "parallel.h"
+
+#define CPA2_DEFAULT_BATCH 128
+#define CPA2_TILE_PAIRS 512
+#define CPA2_MAX_THREADS 256
+
+struct Cpa2 {
+    Cpa2Config cfg;
+    int trace_length;
+    int region;             // end - start
+    size_t num_pairs;
+    int *pair_i;            // offsets into the region, i-major order
+    int *pair_j;
+    int threads;
+
+    double *mean_sum;
+    size_t mean_count;
+    float *mean;
+    int mean_ready;
+
+    size_t n;
+    double sum_h[256];
+    double sum_h2[256];
+    double *sum_x;          // [num_pairs]
+    double *sum_x2;         // [num_pairs]
+    double *sum_hx;         // [256][num_pairs]
+
+    // Per batch scratch
+    size_t batch_rows;
+    float *centered;        // [batch][region]
+    float *hyp;             // [256][batch]
+    float *tile_x[CPA2_MAX_THREADS];    // [batch][CPA2_TILE_PAIRS]
+    float *tile_acc[CPA2_MAX_THREADS];  // [CPA2_TILE_PAIRS]
+};
+
+Cpa2 *cpa2_create(const Cpa2Config *cfg, int trace_length) {
+    if (cfg->start < 0 || cfg->end > trace_length || cfg->end - cfg->start < 2 ||
+        cfg->window < 1 || cfg->byte < 0 || cfg->byte > 15) {
+        printf("Error: Invalid second-order CPA region/window\n");
+        return NULL;
+    }
+
+    Cpa2 *cpa = calloc(1, sizeof(Cpa2));
+    if (!cpa) return NULL;
+    cpa->cfg = *cfg;
+    if (cpa->cfg.batch == 0) cpa->cfg.batch = CPA2_DEFAULT_BATCH;
+    cpa->trace_length = trace_length;
+    cpa->region = cfg->end - cfg->start;
+    cpa->threads = cfg->threads > 0 ? cfg->threads : parallel_default_threads();
+    if (cpa->threads > CPA2_MAX_THREADS) cpa->threads = CPA2_MAX_THREADS;
+
+    int w = cfg->window < cpa->region - 1 ? cfg->window : cpa->region - 1;
+    size_t pairs = 0;
+    for (int i = 0; i < cpa->region; i++) {
+        int last = i + w < cpa->region - 1 ? i + w : cpa->region - 1;
+        pairs += (size_t)(last - i);
+    }
+    cpa->num_pairs = pairs;
+
+    size_t B = cpa->cfg.batch;
+    cpa->pair_i = malloc(pairs * sizeof(int));
+    cpa->pair_j = malloc(pairs * sizeof(int));
+    cpa->mean_sum = calloc((size_t)cpa->region, sizeof(double));
+    cpa->mean = calloc((size_t)cpa->region, sizeof(float));
+    cpa->sum_x = calloc(pairs, sizeof(double));
+    cpa->sum_x2 = calloc(pairs, sizeof(double));
+    cpa->sum_hx = calloc(256 * pairs, sizeof(double));
+    cpa->centered = malloc(B * (size_t)cpa->region * sizeof(float));
+    cpa->hyp = malloc(256 * B * sizeof(float));
+
+    int ok = cpa->pair_i && cpa->pair_j && cpa->mean_sum && cpa->mean && cpa->sum_x &&
+             cpa->sum_x2 && cpa->sum_hx && cpa->centered && cpa->hyp;
+    for (int t = 0; t < cpa->threads && ok; t++) {
+        cpa->tile_x[t] = malloc(B * CPA2_TILE_PAIRS * sizeof(float));
+        cpa->tile_acc[t] = malloc(CPA2_TILE_PAIRS * sizeof(float));
+        ok = cpa->tile_x[t] && cpa->tile_acc[t];
+    }
+    if (!ok) {
+        printf("Error: Out of memory for %zu sample pairs\n", pairs);
+        cpa2_free(cpa);
+        return NULL;
+    }
+
+    size_t p = 0;
+    for (int i = 0; i < cpa->region; i++) {
+        for (int j = i + 1; j <= i + w && j < cpa->region; j++) {
+            cpa->pair_i[p] = i;
+            cpa->pair_j[p] = j;
+            p++;
+        }
+    }
+    return cpa;
+}
+
+void cpa2_free(Cpa2 *cpa) {
+    if (!cpa) return;
+    for (int t = 0; t < CPA2_MAX_THREADS; t++) {
+        free(cpa->tile_x[t]);
+        free(cpa->tile_acc[t]);
+    }
+    free(cpa->pair_i);
+    free(cpa->pair_j);
+    free(cpa->mean_sum);
+    free(cpa->mean);
+    free(cpa->sum_x);
+    free(cpa->sum_x2);
+    free(cpa->sum_hx);
+    free(cpa->centered);
+    free(cpa->hyp);
+    free(cpa);
+}
+
+typedef struct {
+    Cpa2 *cpa;
+    const TraceSet *batch;
+} MeanTask;
+
+static void mean_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    MeanTask *task = (MeanTask *)ctx;
+    Cpa2 *cpa = task->cpa;
+    for (size_t t = 0; t < task->batch->num_traces; t++) {
+        const float *row = trace_set_row(task->batch, t) + cpa->cfg.start;
+        for (size_t s = begin; s < end; s++) cpa->mean_sum[s] += row[s];
+    }
+}
+
+void cpa2_add_mean(Cpa2 *cpa, const TraceSet *batch) {
+    MeanTask task = { cpa, batch };
+    parallel_for((size_t)cpa->region, cpa->threads, mean_worker, &task);
+    cpa->mean_count += batch->num_traces;
+    cpa->mean_ready = 0;
+}
+
+typedef struct {
+    Cpa2 *cpa;
+    size_t rows;
+} TileTask;
+
+static void tile_worker(void *ctx, size_t begin, size_t end, int worker) {
+    TileTask *task = (TileTask *)ctx;
+    Cpa2 *cpa = task->cpa;
+    const size_t rows = task->rows;
+    const size_t P = cpa->num_pairs;
+    const int region = cpa->region;
+    float *restrict x = cpa->tile_x[worker];
+    float *restrict acc = cpa->tile_acc[worker];
+
+    for (size_t tile = begin; tile < end; tile++) {
+        size_t p0 = tile * CPA2_TILE_PAIRS;
+        size_t np = P - p0 < CPA2_TILE_PAIRS ? P - p0 : CPA2_TILE_PAIRS;
+        const int *pi = cpa->pair_i + p0;
+        const int *pj = cpa->pair_j + p0;
+
+        // Combined samples for this tile of pairs
+        for (size_t b = 0; b < rows; b++) {
+            const float *c = cpa->centered + b * (size_t)region;
+            float *xr = x + b * CPA2_TILE_PAIRS;
+            for (size_t p = 0; p < np; p++) xr[p] = c[pi[p]] * c[pj[p]];
+        }
+
+        for (size_t p = 0; p < np; p++) acc[p] = 0.0f;
+        for (size_t b = 0; b < rows; b++) {
+            const float *xr = x + b * CPA2_TILE_PAIRS;
+            for (size_t p = 0; p < np; p++) acc[p] += xr[p];
+        }
+        for (size_t p = 0; p < np; p++) cpa->sum_x[p0 + p] += acc[p];
+
+        for (size_t p = 0; p < np; p++) acc[p] = 0.0f;
+        for (size_t b = 0; b < rows; b++) {
+            const float *xr = x + b * CPA2_TILE_PAIRS;
+            for (size_t p = 0; p < np; p++) acc[p] += xr[p] * xr[p];
+        }
+        for (size_t p = 0; p < np; p++) cpa->sum_x2[p0 + p] += acc[p];
+
+        // Hypotheses (256 x rows) times combined samples (rows x np)
+        for (int g = 0; g < 256; g++) {
+            const float *h = cpa->hyp + (size_t)g * rows;
+            for (size_t p = 0; p < np; p++) acc[p] = 0.0f;
+            for (size_t b = 0; b < rows; b++) {
+                const float hb = h[b];
+                const float *xr = x + b * CPA2_TILE_PAIRS;
+                for (size_t p = 0; p < np; p++) acc[p] += hb * xr[p];
+            }
+            double *shx = cpa->sum_hx + (size_t)g * P + p0;
+            for (size_t p = 0; p < np; p++) shx[p] += acc[p];
+        }
+    }
+}
+
+static void add_rows(Cpa2 *cpa, const TraceSet *set, size_t first, size_t rows) {
+    const int region = cpa->region;
+    for (size_t b = 0; b < rows; b++) {
+        const float *row = trace_set_row(set, first + b) + cpa->cfg.start;
+        float *c = cpa->centered + b * (size_t)region;
+        for (int s = 0; s < region; s++) c[s] = row[s] - cpa->mean[s];
+    }
+
+    for (int g = 0; g < 256; g++) {
+        float *h = cpa->hyp + (size_t)g * rows;
+        double sh = 0.0, sh2 = 0.0;
+        for (size_t b = 0; b < rows; b++) {
+            int v = leakage_hypothesis(cpa->cfg.target, cpa->cfg.model, set->plaintexts[first + b],
+                                       set->ciphertexts[first + b], cpa->cfg.byte, (uint8_t)g);
+            h[b] = (float)v;
+            sh += v;
+            sh2 += v * v;
+        }
+        cpa->sum_h[g] += sh;
+        cpa->sum_h2[g] += sh2;
+    }
+
+    TileTask task = { cpa, rows };
+    size_t tiles = (cpa->num_pairs + CPA2_TILE_PAIRS - 1) / CPA2_TILE_PAIRS;
+    parallel_for(tiles, cpa->threads, tile_worker, &task);
+    cpa->n += rows;
+}
+
+void cpa2_add(Cpa2 *cpa, const TraceSet *batch) {
+    if (!cpa->mean_ready) {
+        double inv = cpa->mean_count ? 1.0 / (double)cpa->mean_count : 0.0;
+        for (int s = 0; s < cpa->region; s++) cpa->mean[s] = (float)(cpa->mean_sum[s] * inv);
+        cpa->mean_ready = 1;
+    }
+
+    for (size_t first = 0; first < batch->num_traces; first += cpa->cfg.batch) {
+        size_t rows = batch->num_traces - first;
+        if (rows > cpa->cfg.batch) rows = cpa->cfg.batch;
+        add_rows(cpa, batch, first, rows);
+    }
+}
+
+void cpa2_result(const Cpa2 *cpa, Cpa2Result *out) {
+    const double n = (double)cpa->n;
+    const size_t P = cpa->num_pairs;
+    memset(out, 0, sizeof(*out));
+    out->num_traces = cpa->n;
+
+    for (int g = 0; g < 256; g++) {
+        double vh = n * cpa->sum_h2[g] - cpa->sum_h[g] * cpa->sum_h[g];
+        const double *shx = cpa->sum_hx + (size_t)g * P;
+        float best = 0.0f;
+        size_t best_p = 0;
+
+        for (size_t p = 0; p < P && vh > 0.0; p++) {
+            double vx = n * cpa->sum_x2[p] - cpa->sum_x[p] * cpa->sum_x[p];
+            if (vx <= 0.0) continue;
+            double rho = (n * shx[p] - cpa->sum_h[g] * cpa->sum_x[p]) / sqrt(vh * vx);
+            float r = (float)fabs(rho);
+            if (r > best) {
+                best = r;
+                best_p = p;
+            }
+        }
+        out->peak[g] = best;
+        out->peak_i[g] = P ? cpa->cfg.start + cpa->pair_i[best_p] : 0;
+        out->peak_j[g] = P ? cpa->cfg.start + cpa->pair_j[best_p] : 0;
+        if (best > out->peak[out->best_guess]) out->best_guess = g;
+    }
+}
+
+int cpa2_run(const Cpa2Config *cfg, const TraceSet *set, Cpa2Result *out) {
+    Cpa2 *cpa = cpa2_create(cfg, set->trace_length);
+    if (!cpa) return -1;
+    cpa2_add_mean(cpa, set);
+    cpa2_add(cpa, set);
+    cpa2_result(cpa, out);
+    cpa2_free(cpa);
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _CPA2_H_
+#define _CPA2_H_
+
+#include <stddef.h>
+#include "leakage.h"
+#include "trace_store.h"
+
+// Second-order CPA: every sample pair (i, j) with start <= i < j < end and
+// j - i <= window is combined into the centered product
+//   (t[i] - mean[i]) * (t[j] - mean[j])
+// and correlated against the leakage hypotheses of all 256 subkey guesses.
+// The combined samples are built tile by tile per batch of traces and never
+// stored for the whole set.
+typedef struct {
+    int start;
+    int end;
+    int window;
+    int byte;
+    LeakTarget target;
+    LeakModel model;
+    int threads;        // 0 = all online CPUs
+    size_t batch;       // traces per streaming step (0 = default)
+} Cpa2Config;
+
+typedef struct {
+    float peak[256];    // max |correlation| per guess
+    int peak_i[256];    // sample pair where the peak was found
+    int peak_j[256];
+    int best_guess;
+    size_t num_traces;
+} Cpa2Result;
+
+typedef struct Cpa2 Cpa2;
+
+// Return NULL on invalid config or allocation failure.
+Cpa2 *cpa2_create(const Cpa2Config *cfg, int trace_length);
+void cpa2_free(Cpa2 *cpa);
+
+// Pass 1: accumulate the per-sample means over every batch.
+void cpa2_add_mean(Cpa2 *cpa, const TraceSet *batch);
+
+// Pass 2: accumulate centered products and hypotheses over the same batches.
+void cpa2_add(Cpa2 *cpa, const TraceSet *batch);
+
+// Correlations for everything passed to cpa2_add so far.
+void cpa2_result(const Cpa2 *cpa, Cpa2Result *out);
+
+// Both passes over an in-memory set. Return 0, or -1 on invalid config.
+int cpa2_run(const Cpa2Config *cfg, const TraceSet *set, Cpa2Result *out);
+
+#endif // _CPA2_H_
@@ -0,0 +1,255 @@
+// Created by Team "RTL Rangers"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "csv_loader.h"
+#include "parallel.h"
+
+#define CSV_MAX_RANGES 256
+
+// Don't bother splitting below this many bytes per worker
+#define CSV_MIN_RANGE_BYTES (1 << 20)
+
+typedef struct {
+    const char *begin[CSV_MAX_RANGES];
+    const char *end[CSV_MAX_RANGES];
+    size_t lines[CSV_MAX_RANGES];
+    size_t first_row[CSV_MAX_RANGES];
+    TraceSet *set;
+} CsvTask;
+
+static inline int is_blank_line(const char *p, const char *eol) {
+    return p == eol || (p + 1 == eol && *p == '\r');
+}
+
+static inline const char *line_end(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl : end;
+}
+
+static inline int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static inline const char *skip_space(const char *p, const char *eol) {
+    while (p < eol && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Advance past the next ',' (or to the end of the line)
+static inline const char *next_field(const char *p, const char *eol) {
+    while (p < eol && *p != ',') p++;
+    return p < eol ? p + 1 : eol;
+}
+
+// Up to two hex digits, like "%2hhx"
+static const char *parse_hex_byte(const char *p, const char *eol, uint8_t *out) {
+    p = skip_space(p, eol);
+    int v = 0, digits = 0;
+    while (digits < 2 && p < eol) {
+        int h = hex_value(*p);
+        if (h < 0) break;
+        v = v * 16 + h;
+        p++;
+        digits++;
+    }
+    if (digits) *out = (uint8_t)v;
+    return next_field(p, eol);
+}
+
+static const double pow10_tab[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+// Plain decimals ([-]digits[.digits]) are converted inline; anything else
+// (exponents, inf/nan, very long mantissas) goes through strtof.
+static const char *parse_float(const char *p, const char *eol, float *out) {
+    p = skip_space(p, eol);
+    const char *start = p;
+
+    int neg = 0;
+    if (p < eol && (*p == '-' || *p == '+')) {
+        neg = *p == '-';
+        p++;
+    }
+
+    uint64_t mant = 0;
+    int digits = 0, frac = 0;
+    while (p < eol && *p >= '0' && *p <= '9') {
+        mant = mant * 10 + (uint64_t)(*p++ - '0');
+        digits++;
+    }
+    if (p < eol && *p == '.') {
+        p++;
+        while (p < eol && *p >= '0' && *p <= '9') {
+            mant = mant * 10 + (uint64_t)(*p++ - '0');
+            digits++;
+            frac++;
+        }
+    }
+
+    int plain = digits > 0 && digits <= 18 && (p == eol || *p == ',' || *p == '\r' ||
+                                               *p == ' ' || *p == '\t');
+    if (plain) {
+        double v = (double)mant / pow10_tab[frac];
+        *out = (float)(neg ? -v : v);
+        return next_field(p, eol);
+    }
+
+    const char *field_end = start;
+    while (field_end < eol && *field_end != ',') field_end++;
+
+    char buf[64];
+    size_t len = (size_t)(field_end - start);
+    if (len >= sizeof(buf)) len = sizeof(buf) - 1;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    *out = strtof(buf, NULL);
+    return next_field(field_end, eol);
+}
+
+static void parse_row(TraceSet *set, size_t row, const char *p, const char *eol) {
+    for (int i = 0; i < 16; i++) p = parse_hex_byte(p, eol, &set->plaintexts[row][i]);
+    for (int i = 0; i < 16; i++) p = parse_hex_byte(p, eol, &set->ciphertexts[row][i]);
+    for (int i = 0; i < 16; i++) p = parse_hex_byte(p, eol, &set->keys[row][i]);
+
+    float *trace = trace_set_row(set, row);
+    int i = 0;
+    for (; i < set->trace_length && p < eol; i++) p = parse_float(p, eol, &trace[i]);
+    for (; i < set->trace_length; i++) trace[i] = 0.0f;
+}
+
+static void count_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    CsvTask *task = (CsvTask *)ctx;
+    for (size_t r = begin; r < end; r++) {
+        size_t lines = 0;
+        const char *p = task->begin[r];
+        const char *stop = task->end[r];
+        while (p < stop) {
+            const char *eol = line_end(p, stop);
+            if (!is_blank_line(p, eol)) lines++;
+            p = eol + 1;
+        }
+        task->lines[r] = lines;
+    }
+}
+
+static void parse_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    CsvTask *task = (CsvTask *)ctx;
+    for (size_t r = begin; r < end; r++) {
+        size_t row = task->first_row[r];
+        const char *p = task->begin[r];
+        const char *stop = task->end[r];
+        while (p < stop && row < task->set->num_traces) {
+            const char *eol = line_end(p, stop);
+            if (!is_blank_line(p, eol)) parse_row(task->set, row++, p, eol);
+            p = eol + 1;
+        }
+    }
+}
+
+// Whole-file read for when mmap is unavailable
+static char *read_whole_file(int fd, size_t size) {
+    char *buf = malloc(size ? size : 1);
+    if (!buf) return NULL;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buf + done, size - done, (off_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            free(buf);
+            return NULL;
+        }
+        done += (size_t)n;
+    }
+    return buf;
+}
+
+long csv_load_parallel(const char *filename, TraceSet *set, int threads) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Error: Cannot stat file %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    int mapped = 1;
+    char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        mapped = 0;
+        data = read_whole_file(fd, size);
+    } else {
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    if (!data) {
+        printf("Error: Cannot read file %s\n", filename);
+        return -1;
+    }
+
+    const char *end = data + size;
+    const char *body = line_end(data, end); // Skip header
+    body = body < end ? body + 1 : end;
+
+    if (threads <= 0) threads = parallel_default_threads();
+    if (threads > CSV_MAX_RANGES) threads = CSV_MAX_RANGES;
+    size_t body_size = (size_t)(end - body);
+    if ((size_t)threads > body_size / CSV_MIN_RANGE_BYTES + 1) {
+        threads = (int)(body_size / CSV_MIN_RANGE_BYTES + 1);
+    }
+
+    // Range boundaries are moved forward to the next line start
+    CsvTask task;
+    task.set = set;
+    const char *pos = body;
+    for (int r = 0; r < threads; r++) {
+        task.begin[r] = pos;
+        const char *cut = r + 1 < threads ? body + body_size / threads * (r + 1) : end;
+        if (cut < pos) cut = pos;
+        if (cut < end && cut > body && cut[-1] != '\n') {
+            cut = line_end(cut, end);
+            cut = cut < end ? cut + 1 : end;
+        }
+        task.end[r] = cut;
+        pos = cut;
+    }
+
+    parallel_for((size_t)threads, threads, count_worker, &task);
+
+    size_t total = 0;
+    for (int r = 0; r < threads; r++) {
+        task.first_row[r] = total;
+        total += task.lines[r];
+    }
+
+    parallel_for((size_t)threads, threads, parse_worker, &task);
+
+    if (mapped) {
+        munmap(data, size);
+    } else {
+        free(data);
+    }
+    return (long)(total < set->num_traces ? total : set->num_traces);
+}
@@ -0,0 +1,19 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _CSV_LOADER_H_
+#define _CSV_LOADER_H_
+
+#include "trace_store.h"
+
+// Parallel loader for the Power_Trace_Data.csv layout:
+//   header line, then per row 16 plaintext, 16 ciphertext and 16 key hex bytes
+//   followed by up to set->trace_length float samples (missing samples read as 0).
+//
+// The file is mapped, split into byte ranges aligned to line starts, and each
+// worker parses its range into rows whose indices come from a prefix count of
+// the lines in earlier ranges. `set` must already be allocated; rows past
+// set->num_traces are ignored. threads <= 0 uses all online CPUs.
+// Returns the number of rows loaded, or -1 if the file cannot be read.
+long csv_load_parallel(const char *filename, TraceSet *set, int threads);
+
+#endif // _CSV_LOADER_H_
@@ -0,0 +1,147 @@
+// Created by Team "RTL Rangers"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "sca_config.h"
+#include "trace_gen.h"
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -o, --output FILE     output file (default Power_Trace_Data.csv)\n");
+    printf("  -f, --format FMT      csv, bin or packed (default csv); packed stores the\n");
+    printf("                        samples quantized to Q%d.%d\n", FIXED_M, FIXED_N);
+    printf("  -n, --traces N        number of traces\n");
+    printf("  -l, --length L        samples per trace\n");
+    printf("  -s, --seed S          random seed\n");
+    printf("  -t, --threads T       worker threads (default: all CPUs)\n");
+    printf("      --offset V        baseline power level\n");
+    printf("      --sigma V         Gaussian noise standard deviation\n");
+    printf("      --jitter J        max per-trace shift of the leak positions\n");
+    printf("      --fixed-key       same random key for every trace\n");
+    printf("      --masked          mask every intermediate with a random byte whose HW\n");
+    printf("                        leaks --mask-offset samples earlier (default 8); hd\n");
+    printf("                        leaks overwrite a value under an independent mask\n");
+    printf("      --leak P:B:T:M:G  leak at sample P, byte B, target sbox|last,\n");
+    printf("                        model hw|hd, gain G (repeatable, replaces defaults)\n");
+}
+
+static int parse_leak(TraceGenConfig *cfg, const char *spec) {
+    int pos, byte;
+    char target_name[16], model_name[16];
+    float gain;
+    LeakTarget target;
+    LeakModel model;
+
+    if (sscanf(spec, "%d:%d:%15[^:]:%15[^:]:%f", &pos, &byte, target_name, model_name, &gain) != 5 ||
+        leakage_parse_target(target_name, &target) != 0 ||
+        leakage_parse_model(model_name, &model) != 0) {
+        printf("Error: Bad leak spec '%s'\n", spec);
+        return -1;
+    }
+    if (trace_gen_add_leak(cfg, pos, byte, target, model, gain) != 0) {
+        printf("Error: Cannot add leak '%s'\n", spec);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    enum { OPT_OFFSET = 256, OPT_SIGMA, OPT_JITTER, OPT_FIXED_KEY, OPT_MASKED, OPT_MASK_OFFSET, OPT_LEAK };
+    static const struct option options[] = {
+        { "output", required_argument, NULL, 'o' },
+        { "format", required_argument, NULL, 'f' },
+        { "traces", required_argument, NULL, 'n' },
+        { "length", required_argument, NULL, 'l' },
+        { "seed", required_argument, NULL, 's' },
+        { "threads", required_argument, NULL, 't' },
+        { "offset", required_argument, NULL, OPT_OFFSET },
+        { "sigma", required_argument, NULL, OPT_SIGMA },
+        { "jitter", required_argument, NULL, OPT_JITTER },
+        { "fixed-key", no_argument, NULL, OPT_FIXED_KEY },
+        { "masked", no_argument, NULL, OPT_MASKED },
+        { "mask-offset", required_argument, NULL, OPT_MASK_OFFSET },
+        { "leak", required_argument, NULL, OPT_LEAK },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    TraceGenConfig cfg;
+    trace_gen_default_config(&cfg);
+    const char *output = "Power_Trace_Data.csv";
+    const char *format = "csv";
+    int custom_leaks = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:f:n:l:s:t:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'o': output = optarg; break;
+        case 'f': format = optarg; break;
+        case 'n': cfg.num_traces = strtoull(optarg, NULL, 10); break;
+        case 'l': cfg.trace_length = atoi(optarg); break;
+        case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+        case 't': cfg.threads = atoi(optarg); break;
+        case OPT_OFFSET: cfg.offset = strtof(optarg, NULL); break;
+        case OPT_SIGMA: cfg.noise_sigma = strtof(optarg, NULL); break;
+        case OPT_JITTER: cfg.jitter = atoi(optarg); break;
+        case OPT_FIXED_KEY: cfg.fixed_key = 1; break;
+        case OPT_MASKED: cfg.masked = 1; break;
+        case OPT_MASK_OFFSET: cfg.mask_offset = atoi(optarg); break;
+        case OPT_LEAK:
+            if (!custom_leaks) {
+                cfg.num_leaks = 0;
+                custom_leaks = 1;
+            }
+            if (parse_leak(&cfg, optarg) != 0) return 1;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.trace_length <= 0) {
+        printf("Error: Trace length must be positive\n");
+        return 1;
+    }
+    // gen_one skips leaks outside the trace, which would silently give pure noise
+    for (int l = 0; l < cfg.num_leaks; l++) {
+        if (cfg.leaks[l].position >= cfg.trace_length) {
+            printf("Error: Leak at sample %d (byte %d) is outside traces of %d samples\n",
+                   cfg.leaks[l].position, cfg.leaks[l].byte, cfg.trace_length);
+            return 1;
+        }
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int rc;
+    if (strcmp(format, "csv") == 0) {
+        rc = trace_gen_write_csv(&cfg, output);
+    } else if (strcmp(format, "bin") == 0) {
+        rc = trace_gen_write_bin(&cfg, output);
+    } else if (strcmp(format, "packed") == 0) {
+        rc = trace_gen_write_packed(&cfg, output, FIXED_M, FIXED_N);
+    } else {
+        printf("Error: Unknown format '%s'\n", format);
+        return 1;
+    }
+    if (rc != 0) return 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    struct stat st;
+    double bytes = stat(output, &st) == 0 ? (double)st.st_size : 0.0;
+    printf("Generated %llu traces x %d samples -> %s (%.1f MB in %.2f s, %.2f GB/s)\n",
+           (unsigned long long)cfg.num_traces, cfg.trace_length, output,
+           bytes / 1e6, secs, secs > 0 ? bytes / secs / 1e9 : 0.0);
+    return 0;
+}
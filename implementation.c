@@ -6,21 +6,12 @@
 #include <stdlib.h>
 #include <math.h>
 #include "aes.h"
+#include "arena.h"
+#include "csv_loader.h"
+#include "sca_config.h"
 
-#define NUM_SAMPLES 2000
-#define TRACE_LENGTH 1024
-
-// Fixed-point config
-#define FIXED_TOTAL_BITS 10
-#define FIXED_M 3
-#define FIXED_N 7
-
-#define HAMMING_TOTAL_BITS 8
-#define HAMMING_M 8
-#define HAMMING_N 0
-
-// Fixed-point conversion (unsigned Qm.n format)
-char* float_to_fixed_bin(float value, int total_bits, int m, int n) {
+// Fixed-point conversion (unsigned Qm.n format), string allocated from `arena`
+char* float_to_fixed_bin(Arena *arena, float value, int total_bits, int m, int n) {
     if (value < 0.0f) {
         printf("Error: Negative value in unsigned fixed-point converter.\n");
         return NULL;
@@ -33,7 +24,7 @@ char* float_to_fixed_bin(float value, int total_bits, int m, int n) {
         fixed_val = (1U << (m + n)) - 1;
     }
 
-    char* bin_str = (char*)malloc(total_bits + 1);
+    char* bin_str = (char*)arena_alloc(arena, total_bits + 1);
     if (!bin_str) return NULL;
 
     for (int i = total_bits - 1; i >= 0; i--) {
@@ -84,56 +75,34 @@ uint8_t keys[NUM_SAMPLES][16];
 uint8_t ciphertexts[NUM_SAMPLES][16];
 float power_traces[NUM_SAMPLES][TRACE_LENGTH];
 
-// Load from CSV
+// Load from CSV (rows are parsed in parallel by csv_load_parallel)
 void load_data_from_csv(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Cannot open file %s\n", filename);
-        return;
-    }
-
-    char line[32768];
-    int sample_idx = 0;
-
-    fgets(line, sizeof(line), file); // Skip header
-
-    while (fgets(line, sizeof(line), file) && sample_idx < NUM_SAMPLES) {
-        char *token = strtok(line, ",");
-
-        for (int i = 0; i < 16; i++) {
-            sscanf(token, "%2hhx", &plaintexts[sample_idx][i]);
-            token = strtok(NULL, ",");
-        }
-
-        for (int i = 0; i < 16; i++) {
-            sscanf(token, "%2hhx", &ciphertexts[sample_idx][i]);
-            token = strtok(NULL, ",");
-        }
-
-        for (int i = 0; i < 16; i++) {
-            sscanf(token, "%2hhx", &keys[sample_idx][i]);
-            token = strtok(NULL, ",");
-        }
-
-        for (int i = 0; i < TRACE_LENGTH; i++) {
-            if (token != NULL) {
-                sscanf(token, "%f", &power_traces[sample_idx][i]);
-                token = strtok(NULL, ",");
-            } else {
-                power_traces[sample_idx][i] = 0.0f;
-            }
-        }
-
-        sample_idx++;
-    }
-
-    fclose(file);
+    TraceSet set = {
+        .num_traces = NUM_SAMPLES,
+        .trace_length = TRACE_LENGTH,
+        .plaintexts = plaintexts,
+        .ciphertexts = ciphertexts,
+        .keys = keys,
+        .traces = &power_traces[0][0],
+        .owns_memory = 0
+    };
+
+    csv_load_parallel(filename, &set, 0);
 }
 
 int main() {
     load_data_from_csv("Power_Trace_Data.csv");
 
+    // Per-sample scratch (binary strings, output text) is reset every sample
+    Arena *arena = arena_thread();
+    if (!arena) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+
     for (int i = 0; i < NUM_SAMPLES; i++) {
+        arena_reset(arena);
+
         uint8_t computed_ct[16];
         struct AES_ctx ctx;
         AES_init_ctx(&ctx, keys[i]);
@@ -154,21 +123,20 @@ int main() {
         features[i].energy = energy;
         features[i].hamming_dist = h_dist;
 
-        char* mean_bin = float_to_fixed_bin(mean, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
-        char* peak_bin = float_to_fixed_bin(peak, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
-        char* energy_bin = float_to_fixed_bin(energy, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
-        char* hd_bin = float_to_fixed_bin((float)h_dist, HAMMING_TOTAL_BITS, HAMMING_M, HAMMING_N);
-
-        printf("Sample %3d:\n", i);
-        printf("  Mean      : %.6f -> %s\n", mean, mean_bin);
-        printf("  Peak      : %.6f -> %s\n", peak, peak_bin);
-        printf("  Energy    : %.6f -> %s\n", energy, energy_bin);
-        printf("  HammingDist: %2d       -> %s (8-bit)\n", h_dist, hd_bin);
-
-        free(mean_bin);
-        free(peak_bin);
-        free(energy_bin);
-        free(hd_bin);
+        char* mean_bin = float_to_fixed_bin(arena, mean, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
+        char* peak_bin = float_to_fixed_bin(arena, peak, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
+        char* energy_bin = float_to_fixed_bin(arena, energy, FIXED_TOTAL_BITS, FIXED_M, FIXED_N);
+        char* hd_bin = float_to_fixed_bin(arena, (float)h_dist, HAMMING_TOTAL_BITS, HAMMING_M, HAMMING_N);
+
+        char* report = arena_printf(arena,
+                                    "Sample %3d:\n"
+                                    "  Mean      : %.6f -> %s\n"
+                                    "  Peak      : %.6f -> %s\n"
+                                    "  Energy    : %.6f -> %s\n"
+                                    "  HammingDist: %2d       -> %s (8-bit)\n",
+                                    i, mean, mean_bin, peak, peak_bin, energy, energy_bin,
+                                    h_dist, hd_bin);
+        if (report) fputs(report, stdout);
     }
 
     // === Find maxima and minima hamming distances from features[] ===
@@ -192,5 +160,15 @@ int main() {
     printf("Minimum Hamming Distance: %d (Sample %d)\n", min_hamming, min_index);
     printf("Maximum Hamming Distance: %d (Sample %d)\n", max_hamming, max_index);
 
+    // Opt-in diagnostics on stderr, so the report itself stays unchanged
+    if (getenv("SCA_ARENA_STATS")) {
+        fprintf(stderr, "\n=== Scratch Arena ===\n");
+        fprintf(stderr, "Bytes allocated : %llu in %llu allocations\n",
+                (unsigned long long)arena->bytes_allocated, (unsigned long long)arena->allocations);
+        fprintf(stderr, "High-water mark : %zu bytes\n", arena->high_water);
+        fprintf(stderr, "Heap calls      : %llu\n", (unsigned long long)arena->heap_calls);
+    }
+    arena_thread_destroy();
+
     return 0;
 }
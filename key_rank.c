@@ -0,0 +1,111 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "key_rank.h"
+
+#define KEY_RANK_MAX_BINS 65536
+
+void key_rank_cpa_loglik(const float peak[256], size_t n, double loglik[256]) {
+    for (int g = 0; g < 256; g++) {
+        double r2 = (double)peak[g] * peak[g];
+        if (r2 > 1.0 - 1e-12) r2 = 1.0 - 1e-12;
+        loglik[g] = -0.5 * (double)n * log1p(-r2);
+    }
+}
+
+void key_rank_log2_probs(const double loglik[256], double log2p[256]) {
+    double best = loglik[0];
+    for (int g = 1; g < 256; g++) {
+        if (loglik[g] > best) best = loglik[g];
+    }
+    double sum = 0.0;
+    for (int g = 0; g < 256; g++) sum += exp(loglik[g] - best);
+    double norm = best + log(sum);
+    for (int g = 0; g < 256; g++) log2p[g] = (loglik[g] - norm) / M_LN2;
+}
+
+int key_rank_byte(const double score[256], uint8_t guess) {
+    int rank = 1;
+    for (int g = 0; g < 256; g++) {
+        if (g != guess && score[g] >= score[guess]) rank++;
+    }
+    return rank;
+}
+
+int key_rank_estimate(const double log2p[16][256], const uint8_t key[16], int bins,
+                      KeyRankEstimate *out) {
+    if (bins < 2 || bins > KEY_RANK_MAX_BINS) return -1;
+
+    double lo = log2p[0][0], hi = log2p[0][0];
+    for (int b = 0; b < 16; b++) {
+        for (int g = 0; g < 256; g++) {
+            if (log2p[b][g] < lo) lo = log2p[b][g];
+            if (log2p[b][g] > hi) hi = log2p[b][g];
+        }
+    }
+    double width = hi > lo ? (hi - lo) / bins : 1.0;
+
+    size_t total = 16 * (size_t)(bins - 1) + 1;
+    double *hist = calloc(total, sizeof(double));
+    double *next = calloc(total, sizeof(double));
+    if (!hist || !next) {
+        free(hist);
+        free(next);
+        return -1;
+    }
+
+    // Convolve one byte at a time; a byte histogram has at most 256 non-empty bins
+    hist[0] = 1.0;
+    size_t len = 1;
+    size_t true_bin = 0;
+    for (int b = 0; b < 16; b++) {
+        int bin_of[256];
+        double count[256];
+        int used[256];
+        int num_used = 0;
+        for (int g = 0; g < 256; g++) {
+            int i = (int)((log2p[b][g] - lo) / width);
+            bin_of[g] = i < bins ? i : bins - 1;
+        }
+        for (int g = 0; g < 256; g++) {
+            int k = 0;
+            while (k < num_used && used[k] != bin_of[g]) k++;
+            if (k == num_used) {
+                used[num_used] = bin_of[g];
+                count[num_used++] = 0.0;
+            }
+            count[k] += 1.0;
+        }
+        true_bin += (size_t)bin_of[key[b]];
+
+        size_t next_len = len + (size_t)bins - 1;
+        memset(next, 0, next_len * sizeof(double));
+        for (int k = 0; k < num_used; k++) {
+            double *dst = next + used[k];
+            const double c = count[k];
+            for (size_t i = 0; i < len; i++) dst[i] += c * hist[i];
+        }
+        double *tmp = hist;
+        hist = next;
+        next = tmp;
+        len = next_len;
+    }
+
+    // Keys in higher bins rank before the true key, which is assumed to sit in
+    // the middle of its own bin; ranks are 1-based, so log2 rank 0 means found.
+    double above = 0.0, lower = 1.0, upper = 0.0;
+    for (size_t i = 0; i < len; i++) {
+        if (i > true_bin) above += hist[i];
+        if (i > true_bin + 16) lower += hist[i];
+        if (i + 16 >= true_bin) upper += hist[i];
+    }
+    out->log2_rank = log2(above + 0.5 * (hist[true_bin] + 1.0));
+    out->log2_lower = log2(lower);
+    out->log2_upper = log2(upper);
+
+    free(hist);
+    free(next);
+    return 0;
+}
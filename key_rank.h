@@ -0,0 +1,41 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _KEY_RANK_H_
+#define _KEY_RANK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Security evaluation of per-byte attack scores: rank of the true subkey and
+// an estimate of the rank of the full 16-byte key among all 2^128 candidates.
+//
+// The full-key rank follows the histogram convolution method: the log2
+// probabilities of each byte are binned on a common grid, the 16 histograms
+// are convolved into the distribution of the key log-probability, and the
+// keys in bins above the true key's bin are counted. Rounding every byte to
+// its bin moves a key by at most one bin per byte, which gives the bounds.
+
+#define KEY_RANK_DEFAULT_BINS 1024
+
+typedef struct {
+    double log2_rank;       // estimate
+    double log2_lower;
+    double log2_upper;
+} KeyRankEstimate;
+
+// Log-likelihood proxy for CPA: a linear leakage model explaining a fraction
+// rho^2 of the variance over n traces has log-likelihood ratio -n/2 ln(1 - rho^2).
+void key_rank_cpa_loglik(const float peak[256], size_t n, double loglik[256]);
+
+// Normalize natural log-likelihoods of the 256 guesses to log2 probabilities.
+void key_rank_log2_probs(const double loglik[256], double log2p[256]);
+
+// Rank of `guess` among the 256 scores (1 = best, ties count against it).
+int key_rank_byte(const double score[256], uint8_t guess);
+
+// Full-key rank of `key` from the log2 probabilities of every byte.
+// Return 0, or -1 if `bins` is out of range or on allocation failure.
+int key_rank_estimate(const double log2p[16][256], const uint8_t key[16], int bins,
+                      KeyRankEstimate *out);
+
+#endif // _KEY_RANK_H_
@@ -0,0 +1,46 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _LEAKAGE_H_
+#define _LEAKAGE_H_
+
+#include <stdint.h>
+
+// AES intermediate whose power consumption is modelled
+typedef enum {
+    LEAK_SBOX_OUT = 0,   // first round SubBytes output S(pt[b] ^ k[b])
+    LEAK_LAST_ROUND = 1  // last round SubBytes input InvS(ct[b] ^ k10[b])
+} LeakTarget;
+
+// How the intermediate turns into power
+typedef enum {
+    LEAK_HW = 0,  // Hamming weight of the intermediate
+    LEAK_HD = 1   // Hamming distance to the value it overwrites
+} LeakModel;
+
+// Hamming weight of every byte value
+extern const uint8_t leakage_hw8[256];
+
+// Byte index in the ciphertext overwritten by the state byte that ends up in ct[byte]
+int leakage_last_round_src(int byte);
+
+// Subkey the target depends on: key[byte] for LEAK_SBOX_OUT, the last
+// round key byte for LEAK_LAST_ROUND
+uint8_t leakage_true_subkey(LeakTarget target, const uint8_t *key, int byte);
+
+// Value of the intermediate for a subkey guess
+uint8_t leakage_intermediate(LeakTarget target, const uint8_t *pt, const uint8_t *ct,
+                             int byte, uint8_t guess);
+
+// Value the intermediate overwrites in the register (LEAK_HD reference)
+uint8_t leakage_previous(LeakTarget target, const uint8_t *pt, const uint8_t *ct,
+                         int byte, uint8_t guess);
+
+// Modelled leakage (0..8) for a subkey guess
+int leakage_hypothesis(LeakTarget target, LeakModel model, const uint8_t *pt,
+                       const uint8_t *ct, int byte, uint8_t guess);
+
+// Parse "sbox"/"last" and "hw"/"hd". Return 0 on success, -1 on unknown names.
+int leakage_parse_target(const char *name, LeakTarget *target);
+int leakage_parse_model(const char *name, LeakModel *model);
+
+#endif // _LEAKAGE_H_
@@ -0,0 +1,110 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linalg.h"
+
+#define JACOBI_MAX_SWEEPS 64
+
+void linalg_sym_eigen(double *a, int n, double *values, double *vectors) {
+    // vectors starts as the identity and accumulates the rotations column-wise
+    double *v = calloc((size_t)n * n, sizeof(double));
+    if (!v) return;
+    for (int i = 0; i < n; i++) v[(size_t)i * n + i] = 1.0;
+
+    for (int sweep = 0; sweep < JACOBI_MAX_SWEEPS; sweep++) {
+        double off = 0.0, diag = 0.0;
+        for (int i = 0; i < n; i++) {
+            diag += a[(size_t)i * n + i] * a[(size_t)i * n + i];
+            for (int j = i + 1; j < n; j++) off += a[(size_t)i * n + j] * a[(size_t)i * n + j];
+        }
+        if (off <= 1e-24 * diag || off == 0.0) break;
+
+        for (int p = 0; p < n - 1; p++) {
+            for (int q = p + 1; q < n; q++) {
+                double apq = a[(size_t)p * n + q];
+                if (apq == 0.0) continue;
+                double app = a[(size_t)p * n + p];
+                double aqq = a[(size_t)q * n + q];
+
+                double theta = (aqq - app) / (2.0 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < n; k++) {
+                    double akp = a[(size_t)k * n + p];
+                    double akq = a[(size_t)k * n + q];
+                    a[(size_t)k * n + p] = c * akp - s * akq;
+                    a[(size_t)k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[(size_t)p * n + k];
+                    double aqk = a[(size_t)q * n + k];
+                    a[(size_t)p * n + k] = c * apk - s * aqk;
+                    a[(size_t)q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double vkp = v[(size_t)k * n + p];
+                    double vkq = v[(size_t)k * n + q];
+                    v[(size_t)k * n + p] = c * vkp - s * vkq;
+                    v[(size_t)k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    // Sort by descending eigenvalue (selection sort, n is small)
+    int *order = malloc((size_t)n * sizeof(int));
+    if (!order) {
+        free(v);
+        return;
+    }
+    for (int i = 0; i < n; i++) order[i] = i;
+    for (int i = 0; i < n; i++) {
+        int best = i;
+        for (int j = i + 1; j < n; j++) {
+            if (a[(size_t)order[j] * n + order[j]] > a[(size_t)order[best] * n + order[best]]) best = j;
+        }
+        int tmp = order[i];
+        order[i] = order[best];
+        order[best] = tmp;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int src = order[i];
+        values[i] = a[(size_t)src * n + src];
+        for (int k = 0; k < n; k++) vectors[(size_t)i * n + k] = v[(size_t)k * n + src];
+    }
+
+    free(order);
+    free(v);
+}
+
+int linalg_cholesky(double *a, int n) {
+    for (int j = 0; j < n; j++) {
+        double d = a[(size_t)j * n + j];
+        for (int k = 0; k < j; k++) d -= a[(size_t)j * n + k] * a[(size_t)j * n + k];
+        if (!(d > 0.0)) return -1;
+        d = sqrt(d);
+        a[(size_t)j * n + j] = d;
+
+        for (int i = j + 1; i < n; i++) {
+            double s = a[(size_t)i * n + j];
+            for (int k = 0; k < j; k++) s -= a[(size_t)i * n + k] * a[(size_t)j * n + k];
+            a[(size_t)i * n + j] = s / d;
+        }
+        for (int i = 0; i < j; i++) a[(size_t)i * n + j] = 0.0;
+    }
+    return 0;
+}
+
+void linalg_forward_subst(const double *l, int n, const double *b, double *y) {
+    for (int i = 0; i < n; i++) {
+        double s = b[i];
+        const double *row = l + (size_t)i * n;
+        for (int k = 0; k < i; k++) s -= row[k] * y[k];
+        y[i] = s / row[i];
+    }
+}
@@ -0,0 +1,21 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _LINALG_H_
+#define _LINALG_H_
+
+// Small dense linear algebra on row-major double matrices.
+
+// Eigen-decomposition of the symmetric n x n matrix `a` (destroyed) by cyclic
+// Jacobi rotations. Eigenvalues are returned in descending order, with the
+// matching unit eigenvectors in the rows of `vectors` (n x n).
+void linalg_sym_eigen(double *a, int n, double *values, double *vectors);
+
+// In-place Cholesky factorization a = L L^T of the symmetric positive definite
+// n x n matrix `a`; L is left in the lower triangle and the upper triangle is
+// zeroed. Returns 0, or -1 if `a` is not positive definite.
+int linalg_cholesky(double *a, int n);
+
+// Solve L y = b for lower triangular L (n x n). `b` and `y` may alias.
+void linalg_forward_subst(const double *l, int n, const double *b, double *y);
+
+#endif // _LINALG_H_
@@ -0,0 +1,69 @@
+// Created by Team "RTL Rangers"
+
+#include <pthread.h>
+#include <unistd.h>
+#include "parallel.h"
+
+#define PARALLEL_MAX_THREADS 256
+
+typedef struct {
+    parallel_fn fn;
+    void *ctx;
+    size_t begin;
+    size_t end;
+    int worker;
+} ParallelTask;
+
+static void *parallel_worker(void *arg) {
+    ParallelTask *task = (ParallelTask *)arg;
+    task->fn(task->ctx, task->begin, task->end, task->worker);
+    return NULL;
+}
+
+int parallel_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    if (n > PARALLEL_MAX_THREADS) return PARALLEL_MAX_THREADS;
+    return (int)n;
+}
+
+void parallel_for(size_t count, int threads, parallel_fn fn, void *ctx) {
+    if (count == 0) return;
+    if (threads <= 0) threads = parallel_default_threads();
+    if (threads > PARALLEL_MAX_THREADS) threads = PARALLEL_MAX_THREADS;
+    if ((size_t)threads > count) threads = (int)count;
+
+    if (threads == 1) {
+        fn(ctx, 0, count, 0);
+        return;
+    }
+
+    pthread_t tids[PARALLEL_MAX_THREADS];
+    ParallelTask tasks[PARALLEL_MAX_THREADS];
+    int started[PARALLEL_MAX_THREADS];
+
+    size_t chunk = count / threads;
+    size_t extra = count % threads;
+    size_t pos = 0;
+
+    for (int t = 0; t < threads; t++) {
+        size_t len = chunk + ((size_t)t < extra ? 1 : 0);
+        tasks[t].fn = fn;
+        tasks[t].ctx = ctx;
+        tasks[t].begin = pos;
+        tasks[t].end = pos + len;
+        tasks[t].worker = t;
+        pos += len;
+    }
+
+    // Worker 0 runs on the calling thread
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&tids[t], NULL, parallel_worker, &tasks[t]) == 0;
+        if (!started[t]) parallel_worker(&tasks[t]);
+    }
+    parallel_worker(&tasks[0]);
+
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+    }
+}
@@ -0,0 +1,18 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <stddef.h>
+
+// Worker callback: process items [begin, end) on worker number `worker`.
+typedef void (*parallel_fn)(void *ctx, size_t begin, size_t end, int worker);
+
+// Number of online CPUs (at least 1).
+int parallel_default_threads(void);
+
+// Split [0, count) into `threads` contiguous ranges and run `fn` on each.
+// threads <= 0 selects parallel_default_threads(). Returns once all ranges are done.
+void parallel_for(size_t count, int threads, parallel_fn fn, void *ctx);
+
+#endif // _PARALLEL_H_
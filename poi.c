@@ -0,0 +1,484 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linalg.h"
+#include "parallel.h"
+#include "poi.h"
+
+#define POI_MAX_CLASSES 256
+#define POI_REDUCTION_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t pca;           // 0: int32 indices follow, 1: mean, basis and variance
+    int32_t input_length;
+    int32_t output_length;
+} PoiReductionHeader;
+
+struct PoiStats {
+    PoiConfig cfg;
+    int trace_length;
+    int classes;
+    size_t count[POI_MAX_CLASSES];
+    double *mean;       // classes x trace_length
+    double *m2;         // classes x trace_length, sum of squared deviations
+    int *batch_class;
+    size_t batch_cap;
+};
+
+PoiStats *poi_stats_create(const PoiConfig *cfg, int trace_length) {
+    if (cfg->byte < 0 || cfg->byte > 15 || trace_length <= 0) return NULL;
+
+    PoiStats *stats = calloc(1, sizeof(PoiStats));
+    if (!stats) return NULL;
+    stats->cfg = *cfg;
+    stats->trace_length = trace_length;
+    stats->classes = cfg->hw_classes ? 9 : 256;
+
+    size_t cells = (size_t)stats->classes * trace_length;
+    stats->mean = calloc(cells, sizeof(double));
+    stats->m2 = calloc(cells, sizeof(double));
+    if (!stats->mean || !stats->m2) {
+        poi_stats_free(stats);
+        return NULL;
+    }
+    return stats;
+}
+
+void poi_stats_free(PoiStats *stats) {
+    if (!stats) return;
+    free(stats->mean);
+    free(stats->m2);
+    free(stats->batch_class);
+    free(stats);
+}
+
+int poi_num_classes(const PoiStats *stats) {
+    return stats->classes;
+}
+
+const double *poi_class_means(const PoiStats *stats) {
+    return stats->mean;
+}
+
+const size_t *poi_class_counts(const PoiStats *stats) {
+    return stats->count;
+}
+
+int poi_class_of(const PoiConfig *cfg, const TraceSet *set, size_t row) {
+    uint8_t subkey = leakage_true_subkey(cfg->target, set->keys[row], cfg->byte);
+    uint8_t v = leakage_intermediate(cfg->target, set->plaintexts[row], set->ciphertexts[row],
+                                     cfg->byte, subkey);
+    return cfg->hw_classes ? leakage_hw8[v] : v;
+}
+
+typedef struct {
+    PoiStats *stats;
+    const TraceSet *batch;
+} StatsTask;
+
+// Welford update of the worker's sample columns, trace by trace
+static void stats_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    StatsTask *task = (StatsTask *)ctx;
+    PoiStats *stats = task->stats;
+    const size_t L = (size_t)stats->trace_length;
+
+    size_t count[POI_MAX_CLASSES];
+    memcpy(count, stats->count, sizeof(count));
+
+    for (size_t t = 0; t < task->batch->num_traces; t++) {
+        int c = stats->batch_class[t];
+        double inv = 1.0 / (double)(++count[c]);
+        const float *x = trace_set_row(task->batch, t);
+        double *restrict mean = stats->mean + (size_t)c * L;
+        double *restrict m2 = stats->m2 + (size_t)c * L;
+
+        for (size_t s = begin; s < end; s++) {
+            double delta = x[s] - mean[s];
+            mean[s] += delta * inv;
+            m2[s] += delta * (x[s] - mean[s]);
+        }
+    }
+}
+
+int poi_stats_add(PoiStats *stats, const TraceSet *batch) {
+    if (batch->trace_length != stats->trace_length) return -1;
+    if (batch->num_traces > stats->batch_cap) {
+        int *cls = realloc(stats->batch_class, batch->num_traces * sizeof(int));
+        if (!cls) {
+            printf("Error: Out of memory for POI statistics\n");
+            return -1;
+        }
+        stats->batch_class = cls;
+        stats->batch_cap = batch->num_traces;
+    }
+    for (size_t t = 0; t < batch->num_traces; t++) {
+        stats->batch_class[t] = poi_class_of(&stats->cfg, batch, t);
+    }
+
+    StatsTask task = { stats, batch };
+    parallel_for((size_t)stats->trace_length, stats->cfg.threads, stats_worker, &task);
+
+    for (size_t t = 0; t < batch->num_traces; t++) stats->count[stats->batch_class[t]]++;
+    return 0;
+}
+
+static float snr_at(const PoiStats *stats, size_t s) {
+    const size_t L = (size_t)stats->trace_length;
+    double sum = 0.0, sum2 = 0.0, noise = 0.0;
+    int used = 0, noisy = 0;
+
+    for (int c = 0; c < stats->classes; c++) {
+        size_t n = stats->count[c];
+        if (n == 0) continue;
+        double m = stats->mean[(size_t)c * L + s];
+        sum += m;
+        sum2 += m * m;
+        used++;
+        if (n > 1) {
+            noise += stats->m2[(size_t)c * L + s] / (double)(n - 1);
+            noisy++;
+        }
+    }
+    if (used < 2 || noisy == 0) return 0.0f;
+
+    double signal = sum2 / used - (sum / used) * (sum / used);
+    noise /= noisy;
+    return noise > 0.0 ? (float)(signal / noise) : 0.0f;
+}
+
+static float sost_at(const PoiStats *stats, size_t s) {
+    const size_t L = (size_t)stats->trace_length;
+    double m[POI_MAX_CLASSES], w[POI_MAX_CLASSES];
+    int used = 0;
+
+    for (int c = 0; c < stats->classes; c++) {
+        size_t n = stats->count[c];
+        if (n < 2) continue;
+        m[used] = stats->mean[(size_t)c * L + s];
+        w[used] = stats->m2[(size_t)c * L + s] / (double)(n - 1) / (double)n;
+        used++;
+    }
+
+    double sost = 0.0;
+    for (int i = 0; i < used; i++) {
+        for (int j = i + 1; j < used; j++) {
+            double d = m[i] - m[j];
+            double den = w[i] + w[j];
+            if (den > 0.0) sost += d * d / den;
+        }
+    }
+    return (float)sost;
+}
+
+typedef struct {
+    const PoiStats *stats;
+    PoiMetric metric;
+    float *out;
+} ScoreTask;
+
+static void score_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    ScoreTask *task = (ScoreTask *)ctx;
+    for (size_t s = begin; s < end; s++) {
+        task->out[s] = task->metric == POI_SOST ? sost_at(task->stats, s) : snr_at(task->stats, s);
+    }
+}
+
+void poi_score(const PoiStats *stats, PoiMetric metric, float *out) {
+    ScoreTask task = { stats, metric, out };
+    parallel_for((size_t)stats->trace_length, stats->cfg.threads, score_worker, &task);
+}
+
+int poi_select_top(const float *score, int trace_length, int k, int min_distance, int *out) {
+    char *blocked = calloc((size_t)trace_length, 1);
+    if (!blocked) return 0;
+
+    int found = 0;
+    while (found < k) {
+        int best = -1;
+        for (int s = 0; s < trace_length; s++) {
+            if (!blocked[s] && (best < 0 || score[s] > score[best])) best = s;
+        }
+        if (best < 0) break;
+
+        out[found++] = best;
+        int lo = best - min_distance + 1, hi = best + min_distance - 1;
+        if (min_distance < 1) lo = hi = best;
+        for (int s = lo < 0 ? 0 : lo; s <= hi && s < trace_length; s++) blocked[s] = 1;
+    }
+
+    free(blocked);
+    return found;
+}
+
+// The covariance of the class means is at most (classes x classes) in rank, so
+// the eigenvectors come from the small Gram matrix G = M M^T of the centered
+// means M: for G u = lambda u, M^T u / sqrt(lambda) is a unit eigenvector of M^T M.
+int poi_pca_build(const PoiStats *stats, int components, PoiPca *pca) {
+    const size_t L = (size_t)stats->trace_length;
+    memset(pca, 0, sizeof(*pca));
+
+    int rows[POI_MAX_CLASSES];
+    int used = 0;
+    size_t total = 0;
+    for (int c = 0; c < stats->classes; c++) {
+        if (stats->count[c] == 0) continue;
+        rows[used++] = c;
+        total += stats->count[c];
+    }
+    if (used < 2) return -1;
+    if (components > used - 1) components = used - 1;
+    if (components < 1) components = 1;
+
+    double *m = malloc((size_t)used * L * sizeof(double));
+    double *center = calloc(L, sizeof(double));
+    double *gram = malloc((size_t)used * used * sizeof(double));
+    double *values = malloc((size_t)used * sizeof(double));
+    double *vectors = malloc((size_t)used * used * sizeof(double));
+    pca->mean = calloc(L, sizeof(float));
+    pca->basis = calloc((size_t)components * L, sizeof(float));
+    pca->variance = calloc((size_t)components, sizeof(float));
+    int rc = (m && center && gram && values && vectors && pca->mean && pca->basis && pca->variance) ? 0 : -1;
+
+    if (rc == 0) {
+        for (int r = 0; r < used; r++) {
+            const double *cm = stats->mean + (size_t)rows[r] * L;
+            double wgt = (double)stats->count[rows[r]] / (double)total;
+            for (size_t s = 0; s < L; s++) center[s] += cm[s] * wgt;
+        }
+        for (size_t s = 0; s < L; s++) pca->mean[s] = (float)center[s];
+        for (int r = 0; r < used; r++) {
+            const double *cm = stats->mean + (size_t)rows[r] * L;
+            for (size_t s = 0; s < L; s++) m[(size_t)r * L + s] = cm[s] - center[s];
+        }
+        for (int i = 0; i < used; i++) {
+            for (int j = i; j < used; j++) {
+                double dot = 0.0;
+                for (size_t s = 0; s < L; s++) dot += m[(size_t)i * L + s] * m[(size_t)j * L + s];
+                gram[(size_t)i * used + j] = gram[(size_t)j * used + i] = dot;
+            }
+        }
+
+        linalg_sym_eigen(gram, used, values, vectors);
+
+        pca->trace_length = (int)L;
+        pca->components = components;
+        for (int k = 0; k < components; k++) {
+            double lambda = values[k] > 0.0 ? values[k] : 0.0;
+            pca->variance[k] = (float)(lambda / used);
+            if (lambda == 0.0) continue;
+
+            double inv = 1.0 / sqrt(lambda);
+            float *row = pca->basis + (size_t)k * L;
+            for (int r = 0; r < used; r++) {
+                double u = vectors[(size_t)k * used + r] * inv;
+                for (size_t s = 0; s < L; s++) row[s] += (float)(u * m[(size_t)r * L + s]);
+            }
+        }
+    }
+
+    free(m);
+    free(center);
+    free(gram);
+    free(values);
+    free(vectors);
+    if (rc != 0) poi_pca_free(pca);
+    return rc;
+}
+
+void poi_pca_free(PoiPca *pca) {
+    free(pca->mean);
+    free(pca->basis);
+    free(pca->variance);
+    memset(pca, 0, sizeof(*pca));
+}
+
+typedef struct {
+    const TraceSet *in;
+    TraceSet *out;
+    const int *idx;
+    const PoiPca *pca;
+} ReduceTask;
+
+static void select_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    ReduceTask *task = (ReduceTask *)ctx;
+    const int k = task->out->trace_length;
+    for (size_t t = begin; t < end; t++) {
+        const float *x = trace_set_row(task->in, t);
+        float *y = trace_set_row(task->out, t);
+        for (int i = 0; i < k; i++) y[i] = x[task->idx[i]];
+    }
+}
+
+static void pca_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    ReduceTask *task = (ReduceTask *)ctx;
+    const PoiPca *pca = task->pca;
+    const size_t L = (size_t)pca->trace_length;
+    for (size_t t = begin; t < end; t++) {
+        const float *x = trace_set_row(task->in, t);
+        float *y = trace_set_row(task->out, t);
+        for (int k = 0; k < pca->components; k++) {
+            const float *b = pca->basis + (size_t)k * L;
+            float acc = 0.0f;
+            for (size_t s = 0; s < L; s++) acc += (x[s] - pca->mean[s]) * b[s];
+            y[k] = acc;
+        }
+    }
+}
+
+static int reduce(const TraceSet *in, int k, TraceSet *out, ReduceTask *task,
+                  parallel_fn worker, int threads) {
+    if (trace_set_alloc(out, in->num_traces, k) != 0) {
+        printf("Error: Out of memory for reduced traces\n");
+        return -1;
+    }
+    memcpy(out->plaintexts, in->plaintexts, in->num_traces * 16);
+    memcpy(out->ciphertexts, in->ciphertexts, in->num_traces * 16);
+    memcpy(out->keys, in->keys, in->num_traces * 16);
+
+    task->in = in;
+    task->out = out;
+    parallel_for(in->num_traces, threads, worker, task);
+    return 0;
+}
+
+int poi_reduce_select(const TraceSet *in, const int *idx, int k, TraceSet *out, int threads) {
+    for (int i = 0; i < k; i++) {
+        if (idx[i] < 0 || idx[i] >= in->trace_length) return -1;
+    }
+    ReduceTask task = { NULL, NULL, idx, NULL };
+    return reduce(in, k, out, &task, select_worker, threads);
+}
+
+int poi_reduce_pca(const TraceSet *in, const PoiPca *pca, TraceSet *out, int threads) {
+    if (pca->trace_length != in->trace_length) return -1;
+    ReduceTask task = { NULL, NULL, NULL, pca };
+    return reduce(in, pca->components, out, &task, pca_worker, threads);
+}
+
+int poi_reduction_from_select(const int *idx, int k, int input_length, PoiReduction *red) {
+    memset(red, 0, sizeof(*red));
+    red->idx = malloc((size_t)(k > 0 ? k : 1) * sizeof(int));
+    if (!red->idx) return -1;
+    memcpy(red->idx, idx, (size_t)k * sizeof(int));
+    red->input_length = input_length;
+    red->output_length = k;
+    return 0;
+}
+
+void poi_reduction_from_pca(PoiPca *pca, PoiReduction *red) {
+    memset(red, 0, sizeof(*red));
+    red->pca = *pca;
+    red->input_length = pca->trace_length;
+    red->output_length = pca->components;
+    memset(pca, 0, sizeof(*pca));
+}
+
+void poi_reduction_free(PoiReduction *red) {
+    free(red->idx);
+    poi_pca_free(&red->pca);
+    memset(red, 0, sizeof(*red));
+}
+
+int poi_reduction_save(const PoiReduction *red, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Cannot create file %s\n", filename);
+        return -1;
+    }
+    PoiReductionHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, POI_REDUCTION_MAGIC, 8);
+    hdr.version = POI_REDUCTION_VERSION;
+    hdr.pca = red->idx == NULL;
+    hdr.input_length = red->input_length;
+    hdr.output_length = red->output_length;
+
+    size_t L = (size_t)red->input_length, k = (size_t)red->output_length;
+    int rc = fwrite(&hdr, sizeof(hdr), 1, file) == 1 ? 0 : -1;
+    if (rc == 0 && red->idx) {
+        for (size_t i = 0; i < k && rc == 0; i++) {
+            int32_t v = red->idx[i];
+            if (fwrite(&v, sizeof(v), 1, file) != 1) rc = -1;
+        }
+    } else if (rc == 0) {
+        if (fwrite(red->pca.mean, sizeof(float), L, file) != L ||
+            fwrite(red->pca.basis, sizeof(float), k * L, file) != k * L ||
+            fwrite(red->pca.variance, sizeof(float), k, file) != k) {
+            rc = -1;
+        }
+    }
+    if (fclose(file) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    return rc;
+}
+
+int poi_reduction_load(const char *filename, PoiReduction *red) {
+    memset(red, 0, sizeof(*red));
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+    PoiReductionHeader hdr;
+    int rc = fread(&hdr, sizeof(hdr), 1, file) == 1 ? 0 : -1;
+    if (rc == 0 && (memcmp(hdr.magic, POI_REDUCTION_MAGIC, 8) != 0 ||
+                    hdr.version != POI_REDUCTION_VERSION || hdr.pca > 1 ||
+                    hdr.input_length <= 0 || hdr.output_length <= 0 ||
+                    (hdr.pca && hdr.output_length > hdr.input_length))) {
+        rc = -1;
+    }
+
+    size_t L = rc == 0 ? (size_t)hdr.input_length : 0, k = rc == 0 ? (size_t)hdr.output_length : 0;
+    if (rc == 0 && !hdr.pca) {
+        red->idx = malloc(k * sizeof(int));
+        for (size_t i = 0; i < k && red->idx && rc == 0; i++) {
+            int32_t v;
+            if (fread(&v, sizeof(v), 1, file) != 1 || v < 0 || v >= hdr.input_length) rc = -1;
+            red->idx[i] = v;
+        }
+        if (!red->idx) rc = -1;
+    } else if (rc == 0) {
+        PoiPca *pca = &red->pca;
+        pca->trace_length = (int)L;
+        pca->components = (int)k;
+        pca->mean = malloc(L * sizeof(float));
+        pca->basis = malloc(k * L * sizeof(float));
+        pca->variance = malloc(k * sizeof(float));
+        if (!pca->mean || !pca->basis || !pca->variance ||
+            fread(pca->mean, sizeof(float), L, file) != L ||
+            fread(pca->basis, sizeof(float), k * L, file) != k * L ||
+            fread(pca->variance, sizeof(float), k, file) != k) {
+            rc = -1;
+        }
+    }
+    fclose(file);
+
+    if (rc != 0) {
+        printf("Error: Not a reduction file %s\n", filename);
+        poi_reduction_free(red);
+        return -1;
+    }
+    red->input_length = (int)L;
+    red->output_length = (int)k;
+    return 0;
+}
+
+int poi_reduction_apply(const PoiReduction *red, const TraceSet *in, TraceSet *out, int threads) {
+    if (in->trace_length != red->input_length) {
+        printf("Error: Reduction expects %d samples per trace, got %d\n", red->input_length,
+               in->trace_length);
+        return -1;
+    }
+    if (red->idx) return poi_reduce_select(in, red->idx, red->output_length, out, threads);
+    return poi_reduce_pca(in, &red->pca, out, threads);
+}
@@ -0,0 +1,92 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _POI_H_
+#define _POI_H_
+
+#include "leakage.h"
+#include "trace_store.h"
+
+// Point-of-interest selection. Traces are grouped into classes by the value
+// of an AES intermediate computed with the true key (the S-box output by
+// default, or its Hamming weight), and per-class running mean/variance of
+// every sample give SNR or SOST leakage scores. The traces can then be reduced
+// to the top-K samples or projected on the main PCA components of the class means.
+
+typedef enum {
+    POI_SNR = 0,
+    POI_SOST = 1
+} PoiMetric;
+
+typedef struct {
+    int byte;
+    LeakTarget target;
+    int hw_classes;     // 9 Hamming weight classes instead of 256 values
+    int threads;        // 0 = all online CPUs
+} PoiConfig;
+
+typedef struct PoiStats PoiStats;
+
+PoiStats *poi_stats_create(const PoiConfig *cfg, int trace_length);
+void poi_stats_free(PoiStats *stats);
+
+// Update the per-class statistics with a batch of profiling traces (known keys).
+// Return 0, or -1 on a trace length mismatch or allocation failure.
+int poi_stats_add(PoiStats *stats, const TraceSet *batch);
+
+int poi_num_classes(const PoiStats *stats);
+
+// Class of one trace: the intermediate (or its HW) under the true key
+int poi_class_of(const PoiConfig *cfg, const TraceSet *set, size_t row);
+
+// Per-class mean of each sample, classes x trace_length (empty classes are 0)
+const double *poi_class_means(const PoiStats *stats);
+const size_t *poi_class_counts(const PoiStats *stats);
+
+// Leakage score of every sample (trace_length floats)
+void poi_score(const PoiStats *stats, PoiMetric metric, float *out);
+
+// Indices of the k best scoring samples, at least min_distance apart,
+// in descending score order. Returns how many were found.
+int poi_select_top(const float *score, int trace_length, int k, int min_distance, int *out);
+
+// PCA of the class means
+typedef struct {
+    int trace_length;
+    int components;
+    float *mean;        // overall mean trace (trace_length)
+    float *basis;       // components x trace_length, unit rows
+    float *variance;    // explained variance per component
+} PoiPca;
+
+// Return 0, or -1 if there are fewer than two non-empty classes.
+int poi_pca_build(const PoiStats *stats, int components, PoiPca *pca);
+void poi_pca_free(PoiPca *pca);
+
+// Reduced trace sets keep the AES data and replace each trace by the selected
+// samples or the PCA coordinates. `out` is allocated. Return 0 or -1.
+int poi_reduce_select(const TraceSet *in, const int *idx, int k, TraceSet *out, int threads);
+int poi_reduce_pca(const TraceSet *in, const PoiPca *pca, TraceSet *out, int threads);
+
+// A fitted reduction (selected samples or PCA projection). It is saved next to
+// the reduced profiling traces so attack traces can be reduced the same way.
+#define POI_REDUCTION_MAGIC "SCATRED1"
+
+typedef struct {
+    int input_length;   // samples of the traces it applies to
+    int output_length;
+    int *idx;           // selected samples (output_length), NULL for PCA
+    PoiPca pca;         // projection when idx is NULL
+} PoiReduction;
+
+// The reduction keeps its own copy of idx / takes ownership of pca.
+int poi_reduction_from_select(const int *idx, int k, int input_length, PoiReduction *red);
+void poi_reduction_from_pca(PoiPca *pca, PoiReduction *red);
+void poi_reduction_free(PoiReduction *red);
+
+int poi_reduction_save(const PoiReduction *red, const char *filename);
+int poi_reduction_load(const char *filename, PoiReduction *red);
+
+// Reduce traces of input_length samples. `out` is allocated. Return 0 or -1.
+int poi_reduction_apply(const PoiReduction *red, const TraceSet *in, TraceSet *out, int threads);
+
+#endif // _POI_H_
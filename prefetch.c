@@ -0,0 +1,395 @@
+// Created by Team "RTL Rangers"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "prefetch.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define PREFETCH_HAVE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef PREFETCH_HAVE_URING
+// Minimal io_uring over the raw syscalls (no liburing dependency)
+typedef struct {
+    int fd;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+} Uring;
+#endif
+
+struct Prefetch {
+    int fd;
+    PrefetchRange *ranges;
+    size_t count;
+    int depth;
+    size_t buf_size;        // per slot, multiple of PREFETCH_ALIGN
+    uint8_t *buffers;       // depth slots; range r is read into slot r % depth
+    size_t *filled;         // bytes read so far per slot
+    int *ready;             // slot holds its complete range
+
+    size_t next;            // next range to hand out
+    size_t submitted;       // ranges whose read has been started
+    size_t inflight;        // io_uring requests not yet completed
+    unsigned unsubmitted;   // of those, queued but not yet consumed by the kernel
+    int holding;            // caller still uses the slot of range next - 1
+    int error;
+
+    int use_uring;
+#ifdef PREFETCH_HAVE_URING
+    Uring ring;
+#endif
+
+    // pread fallback
+    pthread_t thread;
+    int thread_started;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static inline uint8_t *slot_buffer(const Prefetch *pf, size_t range) {
+    return pf->buffers + (range % (size_t)pf->depth) * pf->buf_size;
+}
+
+// Range r may be read once the caller has given back range r - depth
+static inline int can_submit(const Prefetch *pf) {
+    size_t released = pf->next - (size_t)pf->holding;
+    return pf->submitted < pf->count && pf->submitted < released + (size_t)pf->depth;
+}
+
+#ifdef PREFETCH_HAVE_URING
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    for (;;) {
+        long rc = syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+        if (rc >= 0 || errno != EINTR) return (int)rc;
+    }
+}
+
+static int uring_init(Uring *u, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0) return -1;
+
+    // IORING_OP_READ came with the same kernel release as this feature bit
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(u->fd);
+        return -1;
+    }
+
+    u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (u->cq_size > u->sq_size) u->sq_size = u->cq_size;
+        u->cq_size = u->sq_size;
+    }
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    u->sq_ptr = mmap(NULL, u->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                     IORING_OFF_SQ_RING);
+    u->cq_ptr = single ? u->sq_ptr
+                       : mmap(NULL, u->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              u->fd, IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                   IORING_OFF_SQES);
+    if (u->sq_ptr == MAP_FAILED || u->cq_ptr == MAP_FAILED || u->sqes == MAP_FAILED) {
+        if (u->sq_ptr != MAP_FAILED) munmap(u->sq_ptr, u->sq_size);
+        if (!single && u->cq_ptr != MAP_FAILED) munmap(u->cq_ptr, u->cq_size);
+        if (u->sqes != MAP_FAILED) munmap(u->sqes, u->sqes_size);
+        close(u->fd);
+        return -1;
+    }
+
+    char *sq = (char *)u->sq_ptr;
+    char *cq = (char *)u->cq_ptr;
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_close(Uring *u) {
+    munmap(u->sqes, u->sqes_size);
+    if (u->cq_ptr != u->sq_ptr) munmap(u->cq_ptr, u->cq_size);
+    munmap(u->sq_ptr, u->sq_size);
+    close(u->fd);
+}
+
+// Queue the rest of range r into its slot; the kernel sees it on the next enter
+static void uring_queue(Prefetch *pf, size_t r) {
+    Uring *u = &pf->ring;
+    size_t slot = r % (size_t)pf->depth;
+    size_t done = pf->filled[slot];
+
+    unsigned tail = *u->sq_tail;
+    unsigned idx = tail & u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = pf->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(slot_buffer(pf, r) + done);
+    sqe->len = (uint32_t)(pf->ranges[r].size - done);
+    sqe->off = pf->ranges[r].offset + done;
+    sqe->user_data = r;
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    pf->inflight++;
+    pf->unsubmitted++;
+}
+
+// The kernel may consume fewer SQEs than asked; enter until it has all of them,
+// as one left in the queue would never complete
+static void uring_flush(Prefetch *pf) {
+    while (pf->unsubmitted > 0) {
+        int n = uring_enter(pf->ring.fd, pf->unsubmitted, 0, 0);
+        if (n <= 0) {
+            pf->error = 1;
+            return;
+        }
+        pf->unsubmitted -= (unsigned)n;
+    }
+}
+
+static void uring_submit(Prefetch *pf) {
+    while (can_submit(pf)) {
+        pf->filled[pf->submitted % (size_t)pf->depth] = 0;
+        uring_queue(pf, pf->submitted++);
+    }
+    uring_flush(pf);
+}
+
+// Handle every completion; short reads are queued again for the remainder
+static void uring_reap(Prefetch *pf) {
+    Uring *u = &pf->ring;
+    unsigned head = *u->cq_head;
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &u->cqes[head & u->cq_mask];
+        size_t r = (size_t)cqe->user_data;
+        pf->inflight--;
+        size_t slot = r % (size_t)pf->depth;
+        if (pf->error) {
+            continue;
+        } else if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+            uring_queue(pf, r);
+        } else if (cqe->res <= 0) {
+            pf->error = 1;  // I/O error, or end of file inside a range
+        } else {
+            pf->filled[slot] += (size_t)cqe->res;
+            if (pf->filled[slot] < pf->ranges[r].size) {
+                uring_queue(pf, r);
+            } else {
+                pf->ready[slot] = 1;
+            }
+        }
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    uring_flush(pf);
+}
+
+static int uring_wait(Prefetch *pf, size_t slot) {
+    for (;;) {
+        uring_reap(pf);
+        if (pf->error) return -1;
+        if (pf->ready[slot]) return 0;
+        if (uring_enter(pf->ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+            pf->error = 1;
+            return -1;
+        }
+    }
+}
+#endif // PREFETCH_HAVE_URING
+
+int prefetch_pread_full(int fd, void *buf, size_t len, uint64_t offset) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = pread(fd, p, len, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return -1; // truncated file
+        p += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+static void *reader_thread(void *arg) {
+    Prefetch *pf = (Prefetch *)arg;
+    pthread_mutex_lock(&pf->lock);
+    while (!pf->stop && !pf->error && pf->submitted < pf->count) {
+        if (!can_submit(pf)) {
+            pthread_cond_wait(&pf->cond, &pf->lock);
+            continue;
+        }
+        size_t r = pf->submitted++;
+        pthread_mutex_unlock(&pf->lock);
+
+        int rc = prefetch_pread_full(pf->fd, slot_buffer(pf, r), pf->ranges[r].size,
+                                     pf->ranges[r].offset);
+
+        pthread_mutex_lock(&pf->lock);
+        if (rc != 0) {
+            pf->error = 1;
+        } else {
+            pf->ready[r % (size_t)pf->depth] = 1;
+        }
+        pthread_cond_broadcast(&pf->cond);
+    }
+    pthread_mutex_unlock(&pf->lock);
+    return NULL;
+}
+
+Prefetch *prefetch_open(int fd, const PrefetchRange *ranges, size_t count, int depth,
+                        int force_pread) {
+    Prefetch *pf = calloc(1, sizeof(Prefetch));
+    if (!pf) return NULL;
+    pf->fd = fd;
+    pf->count = count;
+    pf->depth = depth > 1 ? depth : PREFETCH_DEFAULT_DEPTH;
+
+    size_t largest = 1;
+    for (size_t i = 0; i < count; i++) {
+        if (ranges[i].size > largest) largest = ranges[i].size;
+    }
+    pf->buf_size = (largest + PREFETCH_ALIGN - 1) / PREFETCH_ALIGN * PREFETCH_ALIGN;
+
+    pf->ranges = malloc((count ? count : 1) * sizeof(PrefetchRange));
+    pf->filled = calloc((size_t)pf->depth, sizeof(size_t));
+    pf->ready = calloc((size_t)pf->depth, sizeof(int));
+    void *buffers = NULL;
+    if (!pf->ranges || !pf->filled || !pf->ready ||
+        posix_memalign(&buffers, PREFETCH_ALIGN, (size_t)pf->depth * pf->buf_size) != 0) {
+        free(pf->ranges);
+        free(pf->filled);
+        free(pf->ready);
+        free(pf);
+        return NULL;
+    }
+    pf->buffers = (uint8_t *)buffers;
+    if (count) memcpy(pf->ranges, ranges, count * sizeof(PrefetchRange));
+    pthread_mutex_init(&pf->lock, NULL);
+    pthread_cond_init(&pf->cond, NULL);
+
+    const char *backend = getenv(PREFETCH_BACKEND_ENV);
+    if (backend && strcmp(backend, "pread") == 0) force_pread = 1;
+
+#ifdef PREFETCH_HAVE_URING
+    if (!force_pread && uring_init(&pf->ring, (unsigned)pf->depth) == 0) {
+        pf->use_uring = 1;
+        uring_submit(pf);
+        return pf;
+    }
+#endif
+
+    if (pthread_create(&pf->thread, NULL, reader_thread, pf) != 0) {
+        prefetch_close(pf);
+        return NULL;
+    }
+    pf->thread_started = 1;
+    return pf;
+}
+
+// The slot stays out of the ring until the next call
+static void take_slot(Prefetch *pf, size_t slot, const uint8_t **data, size_t *size) {
+    pf->ready[slot] = 0;
+    *data = slot_buffer(pf, pf->next);
+    *size = pf->ranges[pf->next].size;
+    pf->holding = 1;
+    pf->next++;
+}
+
+int prefetch_next(Prefetch *pf, const uint8_t **data, size_t *size) {
+    size_t slot = pf->next % (size_t)pf->depth;
+    int rc = 0;
+
+    if (pf->use_uring) {
+#ifdef PREFETCH_HAVE_URING
+        pf->holding = 0;
+        if (pf->error) return -1;
+        if (pf->next == pf->count) return 0;
+        uring_submit(pf);
+        rc = uring_wait(pf, slot);
+        if (rc != 0) return -1;
+        take_slot(pf, slot, data, size);
+#endif
+        return 1;
+    }
+
+    // The reader thread checks next/holding in can_submit, so the slot is
+    // handed out under the lock
+    pthread_mutex_lock(&pf->lock);
+    pf->holding = 0;
+    pthread_cond_broadcast(&pf->cond);
+    while (!pf->error && pf->next < pf->count && !pf->ready[slot]) {
+        pthread_cond_wait(&pf->cond, &pf->lock);
+    }
+    rc = pf->ready[slot] ? 1 : pf->error ? -1 : 0;
+    if (rc == 1) take_slot(pf, slot, data, size);
+    pthread_mutex_unlock(&pf->lock);
+    return rc;
+}
+
+void prefetch_close(Prefetch *pf) {
+    if (!pf) return;
+    if (pf->thread_started) {
+        pthread_mutex_lock(&pf->lock);
+        pf->stop = 1;
+        pthread_cond_broadcast(&pf->cond);
+        pthread_mutex_unlock(&pf->lock);
+        pthread_join(pf->thread, NULL);
+    }
+#ifdef PREFETCH_HAVE_URING
+    if (pf->use_uring) {
+        // Reads still in flight target our buffers: drain them first. SQEs the
+        // kernel never consumed are dropped with the ring.
+        pf->error = 1;
+        pf->inflight -= pf->unsubmitted;
+        pf->unsubmitted = 0;
+        while (pf->inflight > 0) {
+            uring_reap(pf);
+            if (pf->inflight > 0 && uring_enter(pf->ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) break;
+        }
+        uring_close(&pf->ring);
+    }
+#endif
+    pthread_mutex_destroy(&pf->lock);
+    pthread_cond_destroy(&pf->cond);
+    free(pf->buffers);
+    free(pf->ranges);
+    free(pf->filled);
+    free(pf->ready);
+    free(pf);
+}
+
+const char *prefetch_backend(const Prefetch *pf) {
+    return pf->use_uring ? "io_uring" : "pread";
+}
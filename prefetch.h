@@ -0,0 +1,50 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _PREFETCH_H_
+#define _PREFETCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-ahead of a list of file ranges into a ring of page-aligned buffers.
+// Up to depth - 1 reads are in flight while the caller works on the buffer
+// handed out last; buffers come back in range order, so the ring doubles as
+// a bounded queue between the disk and the analysis stages.
+//
+// Reads are queued with io_uring where the kernel allows it, otherwise a
+// reader thread issues plain preads.
+
+#define PREFETCH_DEFAULT_DEPTH 8
+#define PREFETCH_ALIGN 4096
+
+// Set to "pread" to skip io_uring in every reader, e.g. to test the fallback
+#define PREFETCH_BACKEND_ENV "SCA_PREFETCH"
+
+typedef struct {
+    uint64_t offset;
+    size_t size;
+} PrefetchRange;
+
+typedef struct Prefetch Prefetch;
+
+// Start reading `ranges` (copied) from `fd`, which must stay open until
+// prefetch_close. depth <= 1 selects PREFETCH_DEFAULT_DEPTH; force_pread (or
+// PREFETCH_BACKEND_ENV=pread) skips io_uring. Return NULL on allocation failure.
+Prefetch *prefetch_open(int fd, const PrefetchRange *ranges, size_t count, int depth,
+                        int force_pread);
+
+// Wait for the next range. The previous buffer is recycled by this call, so
+// `data` stays valid until the following one.
+// Return 1 with the data, 0 after the last range, or -1 on a read error.
+int prefetch_next(Prefetch *pf, const uint8_t **data, size_t *size);
+
+void prefetch_close(Prefetch *pf);
+
+// "io_uring" or "pread"
+const char *prefetch_backend(const Prefetch *pf);
+
+// Read exactly `len` bytes at `offset`, retrying short reads and EINTR.
+// Return 0, or -1 on an I/O error or end of file.
+int prefetch_pread_full(int fd, void *buf, size_t len, uint64_t offset);
+
+#endif // _PREFETCH_H_
@@ -0,0 +1,19 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _SCA_CONFIG_H_
+#define _SCA_CONFIG_H_
+
+// Dataset shape of Power_Trace_Data.csv
+#define NUM_SAMPLES 2000
+#define TRACE_LENGTH 1024
+
+// Fixed-point config
+#define FIXED_TOTAL_BITS 10
+#define FIXED_M 3
+#define FIXED_N 7
+
+#define HAMMING_TOTAL_BITS 8
+#define HAMMING_M 8
+#define HAMMING_N 0
+
+#endif // _SCA_CONFIG_H_
@@ -0,0 +1,454 @@
+// Created by Team "RTL Rangers"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "linalg.h"
+#include "parallel.h"
+#include "template.h"
+
+#define TEMPLATE_FILE_VERSION 2
+#define TEMPLATE_ALIGN 64
+#define TEMPLATE_MAX_THREADS 256
+
+// Traces scored together against all classes
+#define ATTACK_BATCH 16
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    int32_t num_poi;
+    int32_t classes;
+    int32_t byte;
+    int32_t target;
+    int32_t hw_classes;
+    int32_t input;
+    int32_t input_length;
+    int32_t full_length;
+    int32_t reserved;
+    uint64_t poi_off;
+    uint64_t full_poi_off;
+    uint64_t chol_off;
+    uint64_t white_off;
+    uint64_t norm_off;
+    uint64_t count_off;
+    uint64_t total_size;
+} TemplateFileHeader;
+
+static uint64_t align_up(uint64_t v) {
+    return (v + TEMPLATE_ALIGN - 1) & ~(uint64_t)(TEMPLATE_ALIGN - 1);
+}
+
+static void layout(TemplateFileHeader *hdr, int num_poi, int classes) {
+    uint64_t k = (uint64_t)num_poi, c = (uint64_t)classes;
+    hdr->num_poi = num_poi;
+    hdr->classes = classes;
+    hdr->poi_off = align_up(sizeof(TemplateFileHeader));
+    hdr->full_poi_off = align_up(hdr->poi_off + k * sizeof(int32_t));
+    hdr->chol_off = align_up(hdr->full_poi_off + k * sizeof(int32_t));
+    hdr->white_off = align_up(hdr->chol_off + k * k * sizeof(double));
+    hdr->norm_off = align_up(hdr->white_off + c * k * sizeof(double));
+    hdr->count_off = align_up(hdr->norm_off + c * sizeof(double));
+    hdr->total_size = align_up(hdr->count_off + c * sizeof(uint32_t));
+}
+
+// Point the Template arrays into a storage block that starts with the header
+static int bind(Template *tpl, void *storage, size_t size, int mapped) {
+    const TemplateFileHeader *hdr = (const TemplateFileHeader *)storage;
+    if (size < sizeof(*hdr) || memcmp(hdr->magic, TEMPLATE_FILE_MAGIC, 8) != 0 ||
+        hdr->version != TEMPLATE_FILE_VERSION || hdr->num_poi <= 0 || hdr->classes <= 0 ||
+        hdr->classes > 256 || hdr->total_size > size) {
+        return -1;
+    }
+    TemplateFileHeader expect;
+    layout(&expect, hdr->num_poi, hdr->classes);
+    if (expect.total_size != hdr->total_size || expect.count_off != hdr->count_off ||
+        expect.full_poi_off != hdr->full_poi_off) {
+        return -1;
+    }
+    // Callers index per-byte tables with the class definition
+    if (hdr->byte < 0 || hdr->byte > 15 ||
+        (hdr->target != LEAK_SBOX_OUT && hdr->target != LEAK_LAST_ROUND) ||
+        (hdr->hw_classes != 0 && hdr->hw_classes != 1) ||
+        hdr->classes != (hdr->hw_classes ? 9 : 256)) {
+        return -1;
+    }
+    if (hdr->input < TEMPLATE_FULL || hdr->input > TEMPLATE_PCA || hdr->input_length <= 0 ||
+        hdr->full_length <= 0 ||
+        (hdr->input == TEMPLATE_FULL && hdr->full_length != hdr->input_length)) {
+        return -1;
+    }
+
+    // The attack indexes traces with the POIs, so they must fit the lengths
+    const char *base = (const char *)storage;
+    const int32_t *poi = (const int32_t *)(base + hdr->poi_off);
+    const int32_t *full_poi = (const int32_t *)(base + hdr->full_poi_off);
+    for (int i = 0; i < hdr->num_poi; i++) {
+        if (poi[i] < 0 || poi[i] >= hdr->input_length) return -1;
+        if (hdr->input != TEMPLATE_PCA && (full_poi[i] < 0 || full_poi[i] >= hdr->full_length)) {
+            return -1;
+        }
+    }
+
+    memset(tpl, 0, sizeof(*tpl));
+    tpl->cls.byte = hdr->byte;
+    tpl->cls.target = (LeakTarget)hdr->target;
+    tpl->cls.hw_classes = hdr->hw_classes;
+    tpl->num_poi = hdr->num_poi;
+    tpl->classes = hdr->classes;
+    tpl->input = (TemplateInput)hdr->input;
+    tpl->input_length = hdr->input_length;
+    tpl->full_length = hdr->full_length;
+    tpl->poi = poi;
+    tpl->full_poi = full_poi;
+    tpl->chol = (const double *)(base + hdr->chol_off);
+    tpl->white = (const double *)(base + hdr->white_off);
+    tpl->half_norm = (const double *)(base + hdr->norm_off);
+    tpl->count = (const uint32_t *)(base + hdr->count_off);
+    tpl->storage = storage;
+    tpl->storage_size = size;
+    tpl->mapped = mapped;
+    return 0;
+}
+
+static inline const float *poi_values(const float *trace, const int32_t *poi, int k, float *tmp) {
+    for (int i = 0; i < k; i++) tmp[i] = trace[poi[i]];
+    return tmp;
+}
+
+typedef struct {
+    const TraceSet *set;
+    const int *cls;
+    const int32_t *poi;
+    int k;
+    const double *mean;     // classes x k
+    double *scatter;        // per worker k x k
+    volatile int error;
+} ScatterTask;
+
+static void scatter_worker(void *ctx, size_t begin, size_t end, int worker) {
+    ScatterTask *task = (ScatterTask *)ctx;
+    const int k = task->k;
+    double *acc = task->scatter + (size_t)worker * k * k;
+    double *d = malloc((size_t)k * sizeof(double));
+    float *tmp = malloc((size_t)k * sizeof(float));
+    if (!d || !tmp) {
+        task->error = 1;
+        free(d);
+        free(tmp);
+        return;
+    }
+
+    for (size_t t = begin; t < end; t++) {
+        const float *x = poi_values(trace_set_row(task->set, t), task->poi, k, tmp);
+        const double *mu = task->mean + (size_t)task->cls[t] * k;
+        for (int i = 0; i < k; i++) d[i] = x[i] - mu[i];
+        for (int i = 0; i < k; i++) {
+            double di = d[i];
+            double *row = acc + (size_t)i * k;
+            for (int j = i; j < k; j++) row[j] += di * d[j];
+        }
+    }
+    free(d);
+    free(tmp);
+}
+
+int template_build(const PoiConfig *cls, const TraceSet *profile, const int *poi, int num_poi,
+                   const PoiReduction *red, Template *tpl) {
+    memset(tpl, 0, sizeof(*tpl));
+    const int k = num_poi;
+    const int classes = cls->hw_classes ? 9 : 256;
+    const size_t n = profile->num_traces;
+    if (k <= 0 || n <= (size_t)classes) {
+        printf("Error: Need POIs and more profiling traces than classes\n");
+        return -1;
+    }
+    for (int i = 0; i < k; i++) {
+        if (poi[i] < 0 || poi[i] >= profile->trace_length) return -1;
+    }
+    if (red && red->output_length != profile->trace_length) {
+        printf("Error: Profiling traces do not match the reduction\n");
+        return -1;
+    }
+
+    TemplateFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TEMPLATE_FILE_MAGIC, 8);
+    hdr.version = TEMPLATE_FILE_VERSION;
+    hdr.byte = cls->byte;
+    hdr.target = cls->target;
+    hdr.hw_classes = cls->hw_classes;
+    hdr.input = !red ? TEMPLATE_FULL : red->idx ? TEMPLATE_SELECTED : TEMPLATE_PCA;
+    hdr.input_length = profile->trace_length;
+    hdr.full_length = red ? red->input_length : profile->trace_length;
+    layout(&hdr, k, classes);
+
+    int threads = cls->threads > 0 ? cls->threads : parallel_default_threads();
+    if (threads > TEMPLATE_MAX_THREADS) threads = TEMPLATE_MAX_THREADS;
+
+    void *storage = calloc(1, (size_t)hdr.total_size);
+    int *trace_cls = malloc(n * sizeof(int));
+    double *mean = calloc((size_t)classes * k, sizeof(double));
+    double *scatter = calloc((size_t)threads * k * k, sizeof(double));
+    float *tmp = malloc((size_t)k * sizeof(float));
+    int rc = (storage && trace_cls && mean && scatter && tmp) ? 0 : -1;
+    if (rc != 0) printf("Error: Out of memory building templates\n");
+
+    if (rc == 0) {
+        memcpy(storage, &hdr, sizeof(hdr));
+        bind(tpl, storage, (size_t)hdr.total_size, 0);
+        int32_t *poi_out = (int32_t *)tpl->poi;
+        int32_t *full_out = (int32_t *)tpl->full_poi;
+        uint32_t *count = (uint32_t *)tpl->count;
+        for (int i = 0; i < k; i++) {
+            poi_out[i] = poi[i];
+            if (hdr.input != TEMPLATE_PCA) full_out[i] = red ? red->idx[poi[i]] : poi[i];
+        }
+
+        // Class means
+        for (size_t t = 0; t < n; t++) {
+            int c = poi_class_of(cls, profile, t);
+            trace_cls[t] = c;
+            count[c]++;
+            const float *x = poi_values(trace_set_row(profile, t), poi_out, k, tmp);
+            double *mu = mean + (size_t)c * k;
+            for (int i = 0; i < k; i++) mu[i] += x[i];
+        }
+        int used = 0;
+        for (int c = 0; c < classes; c++) {
+            if (!count[c]) continue;
+            used++;
+            for (int i = 0; i < k; i++) mean[(size_t)c * k + i] /= count[c];
+        }
+
+        // Pooled covariance
+        ScatterTask task = { profile, trace_cls, poi_out, k, mean, scatter, 0 };
+        parallel_for(n, threads, scatter_worker, &task);
+        if (task.error) {
+            printf("Error: Out of memory building templates\n");
+            rc = -1;
+        }
+
+        for (int w = 1; w < threads; w++) {
+            for (size_t i = 0; i < (size_t)k * k; i++) scatter[i] += scatter[(size_t)w * k * k + i];
+        }
+
+        double *chol = (double *)tpl->chol;
+        double dof = (double)(n - (size_t)used);
+        double ridge = 0.0;
+        for (int attempt = 0; attempt < 2 && rc == 0; attempt++) {
+            for (int i = 0; i < k; i++) {
+                for (int j = i; j < k; j++) {
+                    chol[(size_t)i * k + j] = chol[(size_t)j * k + i] = scatter[(size_t)i * k + j] / dof;
+                }
+                chol[(size_t)i * k + i] += ridge;
+            }
+            if (linalg_cholesky(chol, k) == 0) break;
+
+            // Nearly collinear POIs: retry with a small ridge on the diagonal
+            if (attempt == 1) {
+                printf("Error: Pooled covariance is not positive definite\n");
+                rc = -1;
+            }
+            for (int i = 0; i < k; i++) ridge += 1e-6 * scatter[(size_t)i * k + i] / dof / k;
+            ridge += 1e-30;
+        }
+
+        // Classes never seen in profiling fall back to the overall mean
+        double *overall = calloc((size_t)k, sizeof(double));
+        if (!overall) rc = -1;
+        for (int c = 0; c < classes && rc == 0; c++) {
+            for (int i = 0; i < k; i++) overall[i] += mean[(size_t)c * k + i] * count[c] / (double)n;
+        }
+
+        // Whitened means
+        double *white = (double *)tpl->white;
+        double *half_norm = (double *)tpl->half_norm;
+        for (int c = 0; c < classes && rc == 0; c++) {
+            double *w = white + (size_t)c * k;
+            linalg_forward_subst(chol, k, count[c] ? mean + (size_t)c * k : overall, w);
+            double nn = 0.0;
+            for (int i = 0; i < k; i++) nn += w[i] * w[i];
+            half_norm[c] = 0.5 * nn;
+        }
+        free(overall);
+    }
+
+    free(trace_cls);
+    free(mean);
+    free(scatter);
+    free(tmp);
+    if (rc != 0) {
+        free(storage);
+        memset(tpl, 0, sizeof(*tpl));
+    }
+    return rc;
+}
+
+void template_free(Template *tpl) {
+    if (tpl->mapped) {
+        munmap(tpl->storage, tpl->storage_size);
+    } else {
+        free(tpl->storage);
+    }
+    memset(tpl, 0, sizeof(*tpl));
+}
+
+int template_save(const Template *tpl, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Cannot create file %s\n", filename);
+        return -1;
+    }
+    const TemplateFileHeader *hdr = (const TemplateFileHeader *)tpl->storage;
+    int rc = fwrite(tpl->storage, 1, (size_t)hdr->total_size, file) == hdr->total_size ? 0 : -1;
+    if (fclose(file) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    return rc;
+}
+
+int template_load(const char *filename, Template *tpl) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TemplateFileHeader)) {
+        printf("Error: Not a template file %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error: Cannot map file %s\n", filename);
+        return -1;
+    }
+    if (bind(tpl, map, size, 1) != 0) {
+        printf("Error: Not a template file %s\n", filename);
+        munmap(map, size);
+        return -1;
+    }
+    return 0;
+}
+
+void template_scores_reset(TemplateScores *scores) {
+    memset(scores, 0, sizeof(*scores));
+}
+
+typedef struct {
+    const Template *tpl;
+    const TraceSet *batch;
+    const int32_t *poi;     // POIs in the coordinates of the batch
+    double *loglik;         // per worker [256]
+    volatile int error;
+} AttackTask;
+
+static void attack_worker(void *ctx, size_t begin, size_t end, int worker) {
+    AttackTask *task = (AttackTask *)ctx;
+    const Template *tpl = task->tpl;
+    const int k = tpl->num_poi;
+    const int classes = tpl->classes;
+    double *ll = task->loglik + (size_t)worker * 256;
+
+    double *z = malloc((size_t)ATTACK_BATCH * k * sizeof(double));
+    double *score = malloc((size_t)ATTACK_BATCH * classes * sizeof(double));
+    double *x = malloc((size_t)k * sizeof(double));
+    float *tmp = malloc((size_t)k * sizeof(float));
+    if (!z || !score || !x || !tmp) {
+        task->error = 1;
+        goto out;
+    }
+
+    for (size_t t0 = begin; t0 < end; t0 += ATTACK_BATCH) {
+        int rows = end - t0 < ATTACK_BATCH ? (int)(end - t0) : ATTACK_BATCH;
+        double zz[ATTACK_BATCH];
+
+        // Whiten the traces of this batch
+        for (int r = 0; r < rows; r++) {
+            const float *v = poi_values(trace_set_row(task->batch, t0 + r), task->poi, k, tmp);
+            for (int i = 0; i < k; i++) x[i] = v[i];
+            double *zr = z + (size_t)r * k;
+            linalg_forward_subst(tpl->chol, k, x, zr);
+            zz[r] = 0.0;
+            for (int i = 0; i < k; i++) zz[r] += zr[i] * zr[i];
+        }
+
+        // Batch x class log-likelihoods: Z W^T - |w|^2/2 - |z|^2/2
+        for (int c = 0; c < classes; c++) {
+            const double *w = tpl->white + (size_t)c * k;
+            for (int r = 0; r < rows; r++) {
+                const double *zr = z + (size_t)r * k;
+                double dot = 0.0;
+                for (int i = 0; i < k; i++) dot += zr[i] * w[i];
+                score[(size_t)r * classes + c] = dot - tpl->half_norm[c] - 0.5 * zz[r];
+            }
+        }
+
+        for (int r = 0; r < rows; r++) {
+            size_t t = t0 + r;
+            const double *s = score + (size_t)r * classes;
+            for (int g = 0; g < 256; g++) {
+                uint8_t v = leakage_intermediate(tpl->cls.target, task->batch->plaintexts[t],
+                                                 task->batch->ciphertexts[t], tpl->cls.byte,
+                                                 (uint8_t)g);
+                ll[g] += s[tpl->cls.hw_classes ? leakage_hw8[v] : v];
+            }
+        }
+    }
+
+out:
+    free(z);
+    free(score);
+    free(x);
+    free(tmp);
+}
+
+int template_attack(const Template *tpl, const TraceSet *batch, TemplateScores *scores,
+                    int threads) {
+    const int32_t *poi;
+    if (batch->trace_length == tpl->input_length) {
+        poi = tpl->poi;
+    } else if (tpl->input != TEMPLATE_PCA && batch->trace_length == tpl->full_length) {
+        poi = tpl->full_poi;
+    } else {
+        if (tpl->input == TEMPLATE_FULL) {
+            printf("Error: Templates expect traces of %d samples, got %d\n", tpl->input_length,
+                   batch->trace_length);
+        } else {
+            printf("Error: Templates expect traces reduced to %d samples%s, got %d\n",
+                   tpl->input_length, tpl->input == TEMPLATE_PCA ? " (apply the PCA reduction)" : "",
+                   batch->trace_length);
+        }
+        return -1;
+    }
+
+    if (threads <= 0) threads = parallel_default_threads();
+    if (threads > TEMPLATE_MAX_THREADS) threads = TEMPLATE_MAX_THREADS;
+
+    double *loglik = calloc((size_t)threads * 256, sizeof(double));
+    if (!loglik) {
+        printf("Error: Out of memory for template scores\n");
+        return -1;
+    }
+
+    AttackTask task = { tpl, batch, poi, loglik, 0 };
+    parallel_for(batch->num_traces, threads, attack_worker, &task);
+    if (task.error) {
+        printf("Error: Out of memory for template scores\n");
+        free(loglik);
+        return -1;
+    }
+
+    for (int w = 0; w < threads; w++) {
+        for (int g = 0; g < 256; g++) scores->loglik[g] += loglik[(size_t)w * 256 + g];
+    }
+    scores->num_traces += batch->num_traces;
+    free(loglik);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _TEMPLATE_H_
+#define _TEMPLATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "poi.h"
+#include "trace_store.h"
+
+// Gaussian template attack with a pooled covariance.
+//
+// Profiling: per-class means mu_c and one pooled covariance S over the POIs,
+// factorized S = L L^T. Templates store the whitened means w_c = L^-1 mu_c,
+// so the log-likelihood of a trace x under class c is, up to a constant,
+//   z . w_c - |w_c|^2 / 2 - |z|^2 / 2   with z = L^-1 x,
+// and a batch of traces is scored against all classes with one matrix product.
+
+#define TEMPLATE_FILE_MAGIC "SCATMPL1"
+
+// Traces the templates were profiled on
+typedef enum {
+    TEMPLATE_FULL = 0,      // full length traces
+    TEMPLATE_SELECTED = 1,  // reduced to selected samples, which map back to full traces
+    TEMPLATE_PCA = 2        // PCA coordinates, attack traces must be reduced the same way
+} TemplateInput;
+
+typedef struct {
+    PoiConfig cls;          // class definition (byte, target, value or HW classes)
+    int num_poi;
+    int classes;
+    TemplateInput input;
+    int input_length;       // samples per profiling trace
+    int full_length;        // samples per trace before the reduction
+    const int32_t *poi;     // sample index of each POI in the profiling traces
+    const int32_t *full_poi;// the same samples in full length traces (not for TEMPLATE_PCA)
+    const double *chol;     // num_poi x num_poi lower triangular L
+    const double *white;    // classes x num_poi whitened means
+    const double *half_norm;// classes: |w_c|^2 / 2
+    const uint32_t *count;  // profiling traces per class
+
+    void *storage;          // malloc'd block or file mapping backing the arrays
+    size_t storage_size;
+    int mapped;
+} Template;
+
+// Build templates on samples poi[0..num_poi) of the profiling traces (known keys).
+// `red` is the reduction the profiling traces went through, NULL for full traces.
+// Return 0, or -1 on invalid input, a singular covariance or allocation failure.
+int template_build(const PoiConfig *cls, const TraceSet *profile, const int *poi, int num_poi,
+                   const PoiReduction *red, Template *tpl);
+void template_free(Template *tpl);
+
+// Serialize to a file laid out exactly like the in-memory arrays, so
+// template_load can map it and use it in place. Return 0 or -1.
+int template_save(const Template *tpl, const char *filename);
+int template_load(const char *filename, Template *tpl);
+
+// Log-likelihood of every subkey guess, summed over all traces scored so far
+typedef struct {
+    double loglik[256];
+    size_t num_traces;
+} TemplateScores;
+
+void template_scores_reset(TemplateScores *scores);
+
+// Score a batch of attack traces and accumulate into `scores`. The traces are
+// reduced like the profiling set, or full length for TEMPLATE_FULL and
+// TEMPLATE_SELECTED. Return 0, or -1 if their length matches neither or memory
+// runs out; `scores` is left unchanged on error.
+int template_attack(const Template *tpl, const TraceSet *batch, TemplateScores *scores,
+                    int threads);
+
+#endif // _TEMPLATE_H_
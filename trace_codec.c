@@ -0,0 +1,507 @@
+// Created by Team "RTL Rangers"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parallel.h"
+#include "trace_codec.h"
+
+#define BLOCK_HEADER_SIZE 8
+#define BLOCK_PADDING 8
+#define TRACE_HEADER_SIZE 3
+
+// Blocks encoded per parallel step while writing
+#define WRITE_GROUP_PER_THREAD 4
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline size_t packed_bytes(int bits, int trace_length) {
+    return ((size_t)bits * (size_t)(trace_length - 1) + 7) / 8;
+}
+
+size_t trace_codec_block_bound(size_t count, int trace_length) {
+    // Deltas of int16 samples need at most 17 bits after zigzag
+    return BLOCK_HEADER_SIZE + count * 48 +
+           count * (TRACE_HEADER_SIZE + packed_bytes(17, trace_length)) + BLOCK_PADDING;
+}
+
+static uint8_t *encode_trace(const int16_t *x, int len, uint8_t *dst) {
+    uint32_t max_zz = 0;
+    for (int i = 1; i < len; i++) {
+        uint32_t zz = zigzag((int32_t)x[i] - (int32_t)x[i - 1]);
+        if (zz > max_zz) max_zz = zz;
+    }
+    int bits = max_zz ? 32 - __builtin_clz(max_zz) : 0;
+
+    memcpy(dst, &x[0], 2);
+    dst[2] = (uint8_t)bits;
+    dst += TRACE_HEADER_SIZE;
+    if (bits == 0) return dst;
+
+    uint64_t acc = 0;
+    int filled = 0;
+    for (int i = 1; i < len; i++) {
+        acc |= (uint64_t)zigzag((int32_t)x[i] - (int32_t)x[i - 1]) << filled;
+        filled += bits;
+        while (filled >= 8) {
+            *dst++ = (uint8_t)acc;
+            acc >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0) *dst++ = (uint8_t)acc;
+    return dst;
+}
+
+static const uint8_t *decode_trace(const uint8_t *src, int len, float scale, float *out) {
+    int16_t first;
+    memcpy(&first, src, 2);
+    int bits = src[2];
+    src += TRACE_HEADER_SIZE;
+
+    int32_t prev = first;
+    out[0] = (float)prev * scale;
+    if (bits == 0) {
+        for (int i = 1; i < len; i++) out[i] = out[0];
+        return src;
+    }
+
+    const uint64_t mask = (1ULL << bits) - 1;
+    size_t bitpos = 0;
+    for (int i = 1; i < len; i++) {
+        uint64_t word;
+        memcpy(&word, src + (bitpos >> 3), 8);
+        uint32_t zz = (uint32_t)((word >> (bitpos & 7)) & mask);
+        bitpos += (size_t)bits;
+        prev += unzigzag(zz);
+        out[i] = (float)prev * scale;
+    }
+    return src + packed_bytes(bits, len);
+}
+
+size_t trace_codec_encode_block(const TraceSet *meta, const int16_t *samples, size_t count,
+                                uint8_t *dst) {
+    uint8_t *p = dst;
+    uint32_t head[2] = { (uint32_t)count, 0 };
+    memcpy(p, head, BLOCK_HEADER_SIZE);
+    p += BLOCK_HEADER_SIZE;
+
+    for (size_t r = 0; r < count; r++) {
+        memcpy(p, meta->plaintexts[r], 16);
+        memcpy(p + 16, meta->ciphertexts[r], 16);
+        memcpy(p + 32, meta->keys[r], 16);
+        p += 48;
+    }
+
+    int len = meta->trace_length;
+    for (size_t r = 0; r < count; r++) {
+        p = encode_trace(samples + r * (size_t)len, len, p);
+    }
+
+    memset(p, 0, BLOCK_PADDING);
+    return (size_t)(p + BLOCK_PADDING - dst);
+}
+
+long trace_codec_decode_block(const uint8_t *src, size_t size, float scale, TraceSet *set,
+                              size_t first_row, size_t max_rows) {
+    if (size < BLOCK_HEADER_SIZE + BLOCK_PADDING) return -1;
+    uint32_t head[2];
+    memcpy(head, src, BLOCK_HEADER_SIZE);
+    size_t count = head[0];
+
+    int len = set->trace_length;
+    const uint8_t *end = src + size - BLOCK_PADDING;
+    const uint8_t *p = src + BLOCK_HEADER_SIZE;
+    if ((size_t)(end - p) < count * 48) return -1;
+
+    size_t rows = count < max_rows ? count : max_rows;
+    for (size_t r = 0; r < rows; r++) {
+        memcpy(set->plaintexts[first_row + r], p + r * 48, 16);
+        memcpy(set->ciphertexts[first_row + r], p + r * 48 + 16, 16);
+        memcpy(set->keys[first_row + r], p + r * 48 + 32, 16);
+    }
+    p += count * 48;
+
+    for (size_t r = 0; r < rows; r++) {
+        if (end - p < TRACE_HEADER_SIZE || p[2] > 17 ||
+            (size_t)(end - p) < TRACE_HEADER_SIZE + packed_bytes(p[2], len)) {
+            return -1;
+        }
+        p = decode_trace(p, len, scale, trace_set_row(set, first_row + r));
+    }
+    return (long)rows;
+}
+
+size_t trace_codec_quantize(const float *in, int16_t *out, size_t count, int m, int n) {
+    int bits = m + n;
+    if (bits > 15) bits = 15;
+    const float hi = (float)((1 << bits) - 1);
+    const float lo = -(float)(1 << bits);
+    const float step = (float)(1 << n);
+
+    size_t clipped = 0;
+    for (size_t i = 0; i < count; i++) {
+        float q = rintf(in[i] * step);
+        if (q > hi) {
+            q = hi;
+            clipped++;
+        }
+        if (q < lo) {
+            q = lo;
+            clipped++;
+        }
+        out[i] = (int16_t)q;
+    }
+    return clipped;
+}
+
+typedef struct {
+    const TraceSet *meta;
+    const int16_t *samples;  // ADC-native input, or NULL to quantize meta->traces
+    int m, n;
+    size_t first_block;
+    size_t num_traces;
+    uint8_t **out;           // per block in the current group
+    size_t *out_size;
+    int16_t **scratch;       // per worker quantization buffer
+    uint64_t *clipped;       // per worker saturated samples
+} EncodeTask;
+
+static void encode_worker(void *ctx, size_t begin, size_t end, int worker) {
+    EncodeTask *task = (EncodeTask *)ctx;
+    size_t len = (size_t)task->meta->trace_length;
+
+    for (size_t b = begin; b < end; b++) {
+        size_t first = (task->first_block + b) * TRACE_CODEC_BLOCK_TRACES;
+        size_t count = task->num_traces - first;
+        if (count > TRACE_CODEC_BLOCK_TRACES) count = TRACE_CODEC_BLOCK_TRACES;
+
+        TraceSet view = *task->meta;
+        view.plaintexts += first;
+        view.ciphertexts += first;
+        view.keys += first;
+
+        const int16_t *samples;
+        if (task->samples) {
+            samples = task->samples + first * len;
+        } else {
+            task->clipped[worker] += trace_codec_quantize(trace_set_row(task->meta, first),
+                                                          task->scratch[worker], count * len,
+                                                          task->m, task->n);
+            samples = task->scratch[worker];
+        }
+        task->out_size[b] = trace_codec_encode_block(&view, samples, count, task->out[b]);
+    }
+}
+
+struct TraceCodecWriter {
+    FILE *file;
+    TraceFileHeader hdr;
+    int threads;
+    size_t group;            // blocks encoded per parallel step
+    uint8_t **out;
+    size_t *out_size;
+    int16_t **scratch;
+    uint64_t *clipped;       // per worker, summed into `saturated` after each batch
+    uint64_t saturated;      // quantized samples outside the Qm.n range
+    uint64_t quantized;
+    int m, n;
+    uint64_t *index;         // file offset of every block written so far
+    size_t num_blocks;
+    size_t index_cap;
+    uint64_t offset;
+    int tail;                // a partial block was written, nothing may follow
+    int error;
+};
+
+static void writer_free(TraceCodecWriter *w) {
+    for (size_t g = 0; w->out && g < w->group; g++) free(w->out[g]);
+    for (int t = 0; w->scratch && t < w->threads; t++) free(w->scratch[t]);
+    free(w->scratch);
+    free(w->clipped);
+    free(w->out_size);
+    free(w->out);
+    free(w->index);
+    free(w);
+}
+
+TraceCodecWriter *trace_codec_writer_open(const char *filename, int trace_length, float scale,
+                                          int threads) {
+    TraceCodecWriter *w = calloc(1, sizeof(TraceCodecWriter));
+    if (!w) return NULL;
+    w->threads = threads > 0 ? threads : parallel_default_threads();
+    w->group = (size_t)w->threads * WRITE_GROUP_PER_THREAD;
+
+    memcpy(w->hdr.magic, TRACE_FILE_MAGIC, 8);
+    w->hdr.version = TRACE_FILE_VERSION;
+    w->hdr.sample_format = TRACE_FORMAT_PACKED;
+    w->hdr.trace_length = (uint32_t)trace_length;
+    w->hdr.data_offset = TRACE_FILE_DATA_OFFSET;
+    w->hdr.sample_scale = scale;
+    w->hdr.block_traces = TRACE_CODEC_BLOCK_TRACES;
+
+    size_t bound = trace_codec_block_bound(TRACE_CODEC_BLOCK_TRACES, trace_length);
+    w->out = calloc(w->group, sizeof(uint8_t *));
+    w->out_size = calloc(w->group, sizeof(size_t));
+    w->scratch = calloc((size_t)w->threads, sizeof(int16_t *));
+    w->clipped = calloc((size_t)w->threads, sizeof(uint64_t));
+    int rc = (trace_length > 0 && w->out && w->out_size && w->scratch && w->clipped) ? 0 : -1;
+    for (size_t g = 0; g < w->group && rc == 0; g++) {
+        w->out[g] = malloc(bound);
+        if (!w->out[g]) rc = -1;
+    }
+    for (int t = 0; t < w->threads && rc == 0; t++) {
+        w->scratch[t] = malloc((size_t)TRACE_CODEC_BLOCK_TRACES * trace_length * sizeof(int16_t));
+        if (!w->scratch[t]) rc = -1;
+    }
+    if (rc != 0) {
+        printf("Error: Cannot set up the packed writer for %s\n", filename);
+        writer_free(w);
+        return NULL;
+    }
+
+    w->file = fopen(filename, "wb");
+    if (!w->file) {
+        printf("Error: Cannot create file %s\n", filename);
+        writer_free(w);
+        return NULL;
+    }
+
+    // The header is written by trace_codec_writer_finish, once the index is known
+    char pad[TRACE_FILE_DATA_OFFSET];
+    memset(pad, 0, sizeof(pad));
+    if (fwrite(pad, 1, sizeof(pad), w->file) != sizeof(pad)) w->error = 1;
+    w->offset = TRACE_FILE_DATA_OFFSET;
+    return w;
+}
+
+static int writer_add(TraceCodecWriter *w, EncodeTask *task) {
+    const TraceSet *batch = task->meta;
+    if (w->error) return -1;
+    if (batch->num_traces == 0) return 0;
+    if (w->tail || batch->trace_length != (int)w->hdr.trace_length) {
+        printf("Error: Packed writer batch does not continue the file\n");
+        w->error = 1;
+        return -1;
+    }
+
+    size_t blocks = (batch->num_traces + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES;
+    if (w->num_blocks + blocks + 1 > w->index_cap) {
+        size_t cap = w->index_cap ? w->index_cap : 1024;
+        while (cap < w->num_blocks + blocks + 1) cap *= 2;
+        uint64_t *index = realloc(w->index, cap * sizeof(uint64_t));
+        if (!index) {
+            printf("Error: Out of memory for the block index\n");
+            w->error = 1;
+            return -1;
+        }
+        w->index = index;
+        w->index_cap = cap;
+    }
+
+    task->num_traces = batch->num_traces;
+    task->out = w->out;
+    task->out_size = w->out_size;
+    task->scratch = w->scratch;
+    task->clipped = w->clipped;
+
+    for (size_t b0 = 0; b0 < blocks && !w->error; b0 += w->group) {
+        size_t nb = blocks - b0 < w->group ? blocks - b0 : w->group;
+        task->first_block = b0;
+        parallel_for(nb, w->threads, encode_worker, task);
+
+        for (size_t b = 0; b < nb; b++) {
+            w->index[w->num_blocks++] = w->offset;
+            if (fwrite(w->out[b], 1, w->out_size[b], w->file) != w->out_size[b]) {
+                w->error = 1;
+                break;
+            }
+            w->offset += w->out_size[b];
+        }
+    }
+    w->hdr.num_traces += batch->num_traces;
+    if (batch->num_traces % TRACE_CODEC_BLOCK_TRACES) w->tail = 1;
+    if (!task->samples) {
+        for (int t = 0; t < w->threads; t++) {
+            w->saturated += w->clipped[t];
+            w->clipped[t] = 0;
+        }
+        w->quantized += batch->num_traces * (uint64_t)batch->trace_length;
+        w->m = task->m;
+        w->n = task->n;
+    }
+    return w->error ? -1 : 0;
+}
+
+int trace_codec_writer_add_int16(TraceCodecWriter *w, const TraceSet *meta,
+                                 const int16_t *samples) {
+    EncodeTask task;
+    memset(&task, 0, sizeof(task));
+    task.meta = meta;
+    task.samples = samples;
+    return writer_add(w, &task);
+}
+
+int trace_codec_writer_add_quantized(TraceCodecWriter *w, const TraceSet *batch, int m, int n) {
+    EncodeTask task;
+    memset(&task, 0, sizeof(task));
+    task.meta = batch;
+    task.m = m;
+    task.n = n;
+    return writer_add(w, &task);
+}
+
+uint64_t trace_codec_writer_saturated(const TraceCodecWriter *w) {
+    return w->saturated;
+}
+
+int trace_codec_writer_finish(TraceCodecWriter *w, const char *filename) {
+    int rc = w->error ? -1 : 0;
+    if (w->saturated) {
+        printf("Warning: %llu of %llu samples overflow the Q%d.%d range and were saturated in %s\n",
+               (unsigned long long)w->saturated, (unsigned long long)w->quantized, w->m, w->n,
+               filename);
+    }
+
+    // Keep the offset table 8-byte aligned for readers that map the file
+    char pad[8] = { 0 };
+    size_t align = (size_t)((8 - w->offset % 8) % 8);
+    if (rc == 0 && align && fwrite(pad, 1, align, w->file) != align) rc = -1;
+    w->offset += align;
+
+    if (rc == 0 && !w->index) {
+        w->index = malloc(sizeof(uint64_t));
+        if (!w->index) rc = -1;
+    }
+    if (rc == 0) {
+        w->index[w->num_blocks] = w->offset;
+        w->hdr.index_offset = w->offset;
+        if (fwrite(w->index, sizeof(uint64_t), w->num_blocks + 1, w->file) != w->num_blocks + 1 ||
+            fseek(w->file, 0, SEEK_SET) != 0 || fwrite(&w->hdr, sizeof(w->hdr), 1, w->file) != 1) {
+            rc = -1;
+        }
+    }
+    if (fclose(w->file) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    writer_free(w);
+    return rc;
+}
+
+int trace_codec_write_int16(const char *filename, const TraceSet *meta, const int16_t *samples,
+                            float scale, int threads) {
+    TraceCodecWriter *w = trace_codec_writer_open(filename, meta->trace_length, scale, threads);
+    if (!w) return -1;
+    trace_codec_writer_add_int16(w, meta, samples);
+    return trace_codec_writer_finish(w, filename);
+}
+
+int trace_codec_write_quantized(const char *filename, const TraceSet *set, int m, int n,
+                                int threads, uint64_t *saturated) {
+    TraceCodecWriter *w = trace_codec_writer_open(filename, set->trace_length,
+                                                  1.0f / (float)(1 << n), threads);
+    if (!w) return -1;
+    trace_codec_writer_add_quantized(w, set, m, n);
+    if (saturated) *saturated = trace_codec_writer_saturated(w);
+    return trace_codec_writer_finish(w, filename);
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const uint64_t *index;
+    float scale;
+    TraceSet *set;
+    volatile int error;
+} DecodeTask;
+
+static void decode_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    DecodeTask *task = (DecodeTask *)ctx;
+    for (size_t b = begin; b < end; b++) {
+        uint64_t lo = task->index[b], hi = task->index[b + 1];
+        size_t first = b * TRACE_CODEC_BLOCK_TRACES;
+        size_t want = task->set->num_traces - first;
+        if (want > TRACE_CODEC_BLOCK_TRACES) want = TRACE_CODEC_BLOCK_TRACES;
+
+        if (hi < lo || hi > task->size ||
+            trace_codec_decode_block(task->data + lo, (size_t)(hi - lo), task->scale, task->set,
+                                     first, want) != (long)want) {
+            task->error = 1;
+        }
+    }
+}
+
+int trace_codec_decode(const uint8_t *data, size_t size, const TraceFileHeader *hdr,
+                       TraceSet *set, int threads) {
+    size_t num_blocks = (size_t)((hdr->num_traces + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES);
+    if (hdr->sample_format != TRACE_FORMAT_PACKED || hdr->block_traces != TRACE_CODEC_BLOCK_TRACES ||
+        hdr->index_offset % 8 != 0 || set->num_traces > hdr->num_traces ||
+        set->trace_length != (int)hdr->trace_length ||
+        hdr->index_offset + (num_blocks + 1) * sizeof(uint64_t) > size) {
+        return -1;
+    }
+
+    DecodeTask task;
+    task.data = data;
+    task.size = size;
+    task.index = (const uint64_t *)(data + hdr->index_offset);
+    task.scale = hdr->sample_scale;
+    task.set = set;
+    task.error = 0;
+
+    size_t blocks = (set->num_traces + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES;
+    parallel_for(blocks, threads, decode_worker, &task);
+    return task.error ? -1 : 0;
+}
+
+long trace_codec_load(const char *filename, TraceSet *set, size_t max_traces, int threads) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+
+    TraceFileHeader hdr;
+    struct stat st;
+    if (trace_store_read_header(fd, &hdr) != 0 || fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+
+    const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: Cannot map file %s\n", filename);
+        return -1;
+    }
+    madvise((void *)data, size, MADV_WILLNEED);
+
+    size_t n = (size_t)hdr.num_traces;
+    if (max_traces && max_traces < n) n = max_traces;
+    if (trace_set_alloc(set, n, (int)hdr.trace_length) != 0) {
+        printf("Error: Out of memory loading %s\n", filename);
+        munmap((void *)data, size);
+        return -1;
+    }
+
+    int rc = trace_codec_decode(data, size, &hdr, set, threads);
+    munmap((void *)data, size);
+
+    if (rc != 0) {
+        printf("Error: Corrupt packed trace file %s\n", filename);
+        trace_set_free(set);
+        return -1;
+    }
+    return (long)n;
+}
@@ -0,0 +1,77 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _TRACE_CODEC_H_
+#define _TRACE_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "trace_store.h"
+
+// Traces per independently decodable block
+#define TRACE_CODEC_BLOCK_TRACES 64
+
+// Block layout (TRACE_FORMAT_PACKED):
+//   uint32 count, uint32 reserved
+//   count x { pt[16], ct[16], key[16] }
+//   count x { int16 first sample, uint8 bits, zigzag(sample[i] - sample[i-1]) for
+//             i = 1 .. trace_length-1 packed LSB first in `bits` bits, padded to a byte }
+//   8 zero bytes, so the decoder can always load 64-bit words
+size_t trace_codec_block_bound(size_t count, int trace_length);
+
+// Encode `count` traces of int16 samples (row-major) plus the AES data of rows
+// 0 .. count-1 of `meta`. Returns the encoded size.
+size_t trace_codec_encode_block(const TraceSet *meta, const int16_t *samples, size_t count,
+                                uint8_t *dst);
+
+// Decode at most max_rows traces of a block into rows first_row.. of `set`,
+// multiplying every sample by `scale`. Return the number of rows decoded, or -1 if corrupt.
+long trace_codec_decode_block(const uint8_t *src, size_t size, float scale, TraceSet *set,
+                              size_t first_row, size_t max_rows);
+
+// Signed Qm.n quantization: round(value * 2^n), saturated to the m+n+1 bit range.
+// Use with FIXED_M / FIXED_N for the same precision as the feature outputs.
+// Return the number of saturated samples.
+size_t trace_codec_quantize(const float *in, int16_t *out, size_t count, int m, int n);
+
+// Streaming PACKED writer: batches are encoded block by block as they come,
+// so the whole set never has to be in memory. Every batch but the last must
+// hold a multiple of TRACE_CODEC_BLOCK_TRACES traces.
+typedef struct TraceCodecWriter TraceCodecWriter;
+
+// Return NULL on error.
+TraceCodecWriter *trace_codec_writer_open(const char *filename, int trace_length, float scale,
+                                          int threads);
+
+// Append ADC-native samples (scale as given to open) or quantize batch->traces
+// to Qm.n (scale 2^-n). Return 0, or -1 on error.
+int trace_codec_writer_add_int16(TraceCodecWriter *w, const TraceSet *meta,
+                                 const int16_t *samples);
+int trace_codec_writer_add_quantized(TraceCodecWriter *w, const TraceSet *batch, int m, int n);
+
+// Quantized samples saturated so far; finish also prints a warning when it is not 0
+uint64_t trace_codec_writer_saturated(const TraceCodecWriter *w);
+
+// Write the block index and the header, close the file and free the writer.
+// Return 0, or -1 if anything failed since open.
+int trace_codec_writer_finish(TraceCodecWriter *w, const char *filename);
+
+// Write a PACKED trace file from ADC-native samples (int8 data widened to int16),
+// with the AES data of `meta`. `scale` converts one ADC step back to float.
+int trace_codec_write_int16(const char *filename, const TraceSet *meta, const int16_t *samples,
+                            float scale, int threads);
+
+// Quantize meta->traces to Qm.n and write them as a PACKED trace file.
+// `saturated` (may be NULL) receives the number of samples outside the range.
+int trace_codec_write_quantized(const char *filename, const TraceSet *set, int m, int n,
+                                int threads, uint64_t *saturated);
+
+// Decode the first set->num_traces traces of a PACKED file image (header included)
+// into `set`, one block per task. Return 0, or -1 if the image is corrupt.
+int trace_codec_decode(const uint8_t *data, size_t size, const TraceFileHeader *hdr,
+                       TraceSet *set, int threads);
+
+// Load up to max_traces traces (0 = all) of a PACKED file, decoding blocks in parallel.
+// Return the number of traces loaded, or -1 on error.
+long trace_codec_load(const char *filename, TraceSet *set, size_t max_traces, int threads);
+
+#endif // _TRACE_CODEC_H_
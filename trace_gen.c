@@ -0,0 +1,421 @@
+// Created by Team "RTL Rangers"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "aes.h"
+#include "parallel.h"
+#include "sca_config.h"
+#include "trace_codec.h"
+#include "trace_gen.h"
+
+// Traces generated per parallel step when writing files
+#define GEN_BATCH 4096
+
+// Worst case CSV text per row: 48 "xx," tokens plus one formatted sample per column
+#define CSV_ROW_FIXED 160
+#define CSV_SAMPLE_MAX 24
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_seed(Rng *rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// xoshiro256+
+static inline uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = s[0] + s[3];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static void rng_bytes(Rng *rng, uint8_t *out, int len) {
+    for (int i = 0; i < len; i += 8) {
+        uint64_t v = rng_next(rng);
+        for (int j = 0; j < 8 && i + j < len; j++) out[i + j] = (uint8_t)(v >> (8 * j));
+    }
+}
+
+// Uniform in (0, 1]
+static inline float rng_unit(Rng *rng) {
+    return ((rng_next(rng) >> 40) + 1) * (1.0f / 16777216.0f);
+}
+
+// Box-Muller, two normals per call
+static void fill_gaussian(Rng *rng, float *out, int len, float mean, float sigma) {
+    const float two_pi = 6.28318530718f;
+    int i = 0;
+    for (; i + 1 < len; i += 2) {
+        float r = sigma * sqrtf(-2.0f * logf(rng_unit(rng)));
+        float a = two_pi * rng_unit(rng);
+        out[i] = mean + r * cosf(a);
+        out[i + 1] = mean + r * sinf(a);
+    }
+    if (i < len) {
+        float r = sigma * sqrtf(-2.0f * logf(rng_unit(rng)));
+        out[i] = mean + r * cosf(two_pi * rng_unit(rng));
+    }
+}
+
+void trace_gen_default_config(TraceGenConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->num_traces = NUM_SAMPLES;
+    cfg->trace_length = TRACE_LENGTH;
+    cfg->seed = 1;
+    cfg->offset = 1.0f;
+    cfg->noise_sigma = 0.05f;
+    cfg->jitter = 0;
+    cfg->mask_offset = 8;
+
+    for (int b = 0; b < 16; b++) {
+        trace_gen_add_leak(cfg, 100 + 20 * b, b, LEAK_SBOX_OUT, LEAK_HW, 0.02f);
+    }
+    for (int b = 0; b < 16; b++) {
+        trace_gen_add_leak(cfg, 600 + 20 * b, b, LEAK_LAST_ROUND, LEAK_HD, 0.02f);
+    }
+}
+
+int trace_gen_add_leak(TraceGenConfig *cfg, int position, int byte, LeakTarget target,
+                       LeakModel model, float gain) {
+    if (cfg->num_leaks >= TRACE_GEN_MAX_LEAKS || position < 0 || byte < 0 || byte > 15) {
+        return -1;
+    }
+    LeakPoint *lp = &cfg->leaks[cfg->num_leaks++];
+    lp->position = position;
+    lp->byte = byte;
+    lp->target = target;
+    lp->model = model;
+    lp->gain = gain;
+    return 0;
+}
+
+// Fixed keys come from their own stream so they don't depend on the trace count
+static void fixed_key(const TraceGenConfig *cfg, uint8_t *key) {
+    Rng rng;
+    rng_seed(&rng, cfg->seed, UINT64_MAX);
+    rng_bytes(&rng, key, 16);
+}
+
+static void gen_one(const TraceGenConfig *cfg, const uint8_t *key_fixed, uint64_t index,
+                    uint8_t *pt, uint8_t *ct, uint8_t *key, float *trace) {
+    Rng rng;
+    rng_seed(&rng, cfg->seed, index);
+
+    rng_bytes(&rng, pt, 16);
+    if (key_fixed) {
+        memcpy(key, key_fixed, 16);
+    } else {
+        rng_bytes(&rng, key, 16);
+    }
+
+    struct AES_ctx ctx;
+    AES_init_ctx(&ctx, key);
+    memcpy(ct, pt, 16);
+    AES_ECB_encrypt(&ctx, ct);
+    const uint8_t *k10 = ctx.RoundKey + AES_keyExpSize - AES_BLOCKLEN;
+
+    int shift = 0;
+    if (cfg->jitter > 0) {
+        shift = (int)(rng_next(&rng) % (uint64_t)(2 * cfg->jitter + 1)) - cfg->jitter;
+    }
+
+    uint8_t masks[16], prev_masks[16];
+    if (cfg->masked) {
+        rng_bytes(&rng, masks, 16);
+        rng_bytes(&rng, prev_masks, 16);
+    }
+
+    fill_gaussian(&rng, trace, cfg->trace_length, cfg->offset, cfg->noise_sigma);
+
+    for (int l = 0; l < cfg->num_leaks; l++) {
+        const LeakPoint *lp = &cfg->leaks[l];
+        int pos = lp->position + shift;
+        if (pos < 0 || pos >= cfg->trace_length) continue;
+
+        uint8_t subkey = lp->target == LEAK_SBOX_OUT ? key[lp->byte] : k10[lp->byte];
+        if (!cfg->masked) {
+            int leak = leakage_hypothesis(lp->target, lp->model, pt, ct, lp->byte, subkey);
+            trace[pos] += lp->gain * (float)leak;
+            continue;
+        }
+
+        uint8_t m = masks[lp->byte];
+        uint8_t v = leakage_intermediate(lp->target, pt, ct, lp->byte, subkey);
+        if (lp->model == LEAK_HD) {
+            // The overwritten value carries an independent mask, so the
+            // transition stays masked by the combination of both
+            v ^= leakage_previous(lp->target, pt, ct, lp->byte, subkey);
+            m ^= prev_masks[lp->byte];
+        }
+        trace[pos] += lp->gain * (float)leakage_hw8[v ^ m];
+        int mask_pos = pos - cfg->mask_offset;
+        if (mask_pos >= 0 && mask_pos < cfg->trace_length) {
+            trace[mask_pos] += lp->gain * (float)leakage_hw8[m];
+        }
+    }
+}
+
+typedef struct {
+    const TraceGenConfig *cfg;
+    const uint8_t *key_fixed;
+    TraceSet *set;
+    uint64_t first_index;
+
+    // File output
+    int fd;
+    const TraceFileHeader *hdr;
+    char **text;         // per-worker CSV text buffers
+    size_t *text_len;
+    volatile int error;
+} GenTask;
+
+static void gen_range(GenTask *task, size_t begin, size_t end) {
+    TraceSet *set = task->set;
+    for (size_t r = begin; r < end; r++) {
+        gen_one(task->cfg, task->key_fixed, task->first_index + r, set->plaintexts[r],
+                set->ciphertexts[r], set->keys[r], trace_set_row(set, r));
+    }
+}
+
+static void gen_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    gen_range((GenTask *)ctx, begin, end);
+}
+
+void trace_gen_fill(const TraceGenConfig *cfg, TraceSet *set, uint64_t first_index, size_t count) {
+    uint8_t key_fixed[16];
+    if (cfg->fixed_key) fixed_key(cfg, key_fixed);
+
+    GenTask task;
+    memset(&task, 0, sizeof(task));
+    task.cfg = cfg;
+    task.key_fixed = cfg->fixed_key ? key_fixed : NULL;
+    task.set = set;
+    task.first_index = first_index;
+    parallel_for(count, cfg->threads, gen_worker, &task);
+}
+
+static const char hex_digits[] = "0123456789abcdef";
+
+// Same text as "%.6f" for |value| < 1e9, without the printf overhead
+static char *format_sample(char *p, float value) {
+    if (!(value > -1e9f && value < 1e9f)) {
+        return p + sprintf(p, "%g", value);
+    }
+    if (value < 0.0f) {
+        *p++ = '-';
+        value = -value;
+    }
+    uint64_t scaled = (uint64_t)((double)value * 1e6 + 0.5);
+    uint64_t ip = scaled / 1000000;
+    uint32_t fp = (uint32_t)(scaled % 1000000);
+
+    char digits[20];
+    int nd = 0;
+    do {
+        digits[nd++] = (char)('0' + ip % 10);
+        ip /= 10;
+    } while (ip);
+    while (nd) *p++ = digits[--nd];
+
+    *p++ = '.';
+    for (int i = 5; i >= 0; i--) {
+        p[i] = (char)('0' + fp % 10);
+        fp /= 10;
+    }
+    return p + 6;
+}
+
+static char *format_hex_row(char *p, const uint8_t *bytes) {
+    for (int i = 0; i < 16; i++) {
+        *p++ = hex_digits[bytes[i] >> 4];
+        *p++ = hex_digits[bytes[i] & 15];
+        *p++ = ',';
+    }
+    return p;
+}
+
+static void csv_worker(void *ctx, size_t begin, size_t end, int worker) {
+    GenTask *task = (GenTask *)ctx;
+    gen_range(task, begin, end);
+
+    const TraceSet *set = task->set;
+    char *p = task->text[worker];
+    for (size_t r = begin; r < end; r++) {
+        p = format_hex_row(p, set->plaintexts[r]);
+        p = format_hex_row(p, set->ciphertexts[r]);
+        p = format_hex_row(p, set->keys[r]);
+        const float *trace = trace_set_row(set, r);
+        for (int i = 0; i < set->trace_length; i++) {
+            p = format_sample(p, trace[i]);
+            *p++ = ',';
+        }
+        p[-1] = '\n';
+    }
+    task->text_len[worker] = (size_t)(p - task->text[worker]);
+}
+
+static void bin_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    GenTask *task = (GenTask *)ctx;
+    gen_range(task, begin, end);
+
+    TraceSet view = *task->set;
+    view.plaintexts += begin;
+    view.ciphertexts += begin;
+    view.keys += begin;
+    view.traces = trace_set_row(task->set, begin);
+    view.owns_memory = 0;
+
+    if (trace_store_write_records(task->fd, task->hdr, &view, task->first_index + begin,
+                                  end - begin) != 0) {
+        task->error = 1;
+    }
+}
+
+static void write_csv_header(FILE *file, int trace_length) {
+    const char *groups[3] = { "pt", "ct", "key" };
+    for (int g = 0; g < 3; g++) {
+        for (int i = 0; i < 16; i++) fprintf(file, "%s%d,", groups[g], i);
+    }
+    for (int i = 0; i < trace_length; i++) {
+        fprintf(file, "t%d%c", i, i + 1 < trace_length ? ',' : '\n');
+    }
+}
+
+static int gen_to_file(const TraceGenConfig *cfg, GenTask *task, parallel_fn worker,
+                       FILE *csv) {
+    int threads = cfg->threads > 0 ? cfg->threads : parallel_default_threads();
+    size_t batch = cfg->num_traces < GEN_BATCH ? (size_t)cfg->num_traces : GEN_BATCH;
+    if (batch == 0) return 0;
+
+    TraceSet set;
+    if (trace_set_alloc(&set, batch, cfg->trace_length) != 0) {
+        printf("Error: Out of memory for generation batch\n");
+        return -1;
+    }
+
+    uint8_t key_fixed[16];
+    if (cfg->fixed_key) fixed_key(cfg, key_fixed);
+    task->cfg = cfg;
+    task->key_fixed = cfg->fixed_key ? key_fixed : NULL;
+    task->set = &set;
+
+    char *text[256] = { 0 };
+    size_t text_len[256] = { 0 };
+    if (csv) {
+        if (threads > 256) threads = 256;
+        size_t rows = batch / threads + 1;
+        size_t cap = rows * (CSV_ROW_FIXED + (size_t)cfg->trace_length * CSV_SAMPLE_MAX);
+        for (int t = 0; t < threads; t++) {
+            text[t] = malloc(cap);
+            if (!text[t]) task->error = 1;
+        }
+        task->text = text;
+        task->text_len = text_len;
+    }
+
+    for (uint64_t first = 0; first < cfg->num_traces && !task->error; first += batch) {
+        size_t count = cfg->num_traces - first < batch ? (size_t)(cfg->num_traces - first) : batch;
+        task->first_index = first;
+        memset(text_len, 0, sizeof(text_len));
+        parallel_for(count, threads, worker, task);
+
+        if (csv) {
+            for (int t = 0; t < threads; t++) {
+                if (text_len[t] && fwrite(text[t], 1, text_len[t], csv) != text_len[t]) {
+                    task->error = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int t = 0; t < 256; t++) free(text[t]);
+    trace_set_free(&set);
+    return task->error ? -1 : 0;
+}
+
+int trace_gen_write_csv(const TraceGenConfig *cfg, const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Cannot create file %s\n", filename);
+        return -1;
+    }
+    write_csv_header(file, cfg->trace_length);
+
+    GenTask task;
+    memset(&task, 0, sizeof(task));
+    int rc = gen_to_file(cfg, &task, csv_worker, file);
+
+    if (fclose(file) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    return rc;
+}
+
+int trace_gen_write_bin(const TraceGenConfig *cfg, const char *filename) {
+    TraceFileHeader hdr;
+    int fd = trace_store_create(filename, cfg->num_traces, cfg->trace_length, &hdr);
+    if (fd < 0) return -1;
+
+    GenTask task;
+    memset(&task, 0, sizeof(task));
+    task.fd = fd;
+    task.hdr = &hdr;
+    int rc = gen_to_file(cfg, &task, bin_worker, NULL);
+
+    if (close(fd) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    return rc;
+}
+
+int trace_gen_write_packed(const TraceGenConfig *cfg, const char *filename, int m, int n) {
+    size_t batch = cfg->num_traces < GEN_BATCH ? (size_t)cfg->num_traces : GEN_BATCH;
+    TraceSet set;
+    if (trace_set_alloc(&set, batch ? batch : 1, cfg->trace_length) != 0) {
+        printf("Error: Out of memory for generation batch\n");
+        return -1;
+    }
+    TraceCodecWriter *w = trace_codec_writer_open(filename, cfg->trace_length,
+                                                  1.0f / (float)(1 << n), cfg->threads);
+    if (!w) {
+        trace_set_free(&set);
+        return -1;
+    }
+
+    // GEN_BATCH is a whole number of codec blocks, so only the last batch is partial
+    int rc = 0;
+    for (uint64_t first = 0; first < cfg->num_traces && rc == 0; first += batch) {
+        size_t count = cfg->num_traces - first < batch ? (size_t)(cfg->num_traces - first) : batch;
+        trace_gen_fill(cfg, &set, first, count);
+        TraceSet view = set;
+        view.num_traces = count;
+        view.owns_memory = 0;
+        rc = trace_codec_writer_add_quantized(w, &view, m, n);
+    }
+    if (trace_codec_writer_finish(w, filename) != 0) rc = -1;
+    trace_set_free(&set);
+    return rc;
+}
@@ -0,0 +1,59 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _TRACE_GEN_H_
+#define _TRACE_GEN_H_
+
+#include <stdint.h>
+#include "leakage.h"
+#include "trace_store.h"
+
+#define TRACE_GEN_MAX_LEAKS 64
+
+// One injected leakage: gain * leakage(target, model, byte) added at `position`
+typedef struct {
+    int position;
+    int byte;
+    LeakTarget target;
+    LeakModel model;
+    float gain;
+} LeakPoint;
+
+typedef struct {
+    uint64_t num_traces;
+    int trace_length;
+    uint64_t seed;
+    int fixed_key;       // one random key for all traces instead of one per trace
+    float offset;        // baseline power level
+    float noise_sigma;   // standard deviation of the Gaussian noise
+    int jitter;          // per-trace shift of all leak positions, uniform in [-jitter, jitter]
+    int masked;          // Boolean masking: leak HW(intermediate ^ m) and HW(m) for a random
+                         // per-trace mask byte m, the latter mask_offset samples earlier.
+                         // HD leaks use HW((v ^ m) ^ (prev ^ m')) with an independent m',
+                         // and HW(m ^ m') as their mask leakage
+    int mask_offset;
+    int threads;         // 0 = all online CPUs
+    int num_leaks;
+    LeakPoint leaks[TRACE_GEN_MAX_LEAKS];
+} TraceGenConfig;
+
+// Defaults: NUM_SAMPLES x TRACE_LENGTH traces, HW of every first round
+// S-box output and HD of every last round byte injected at spaced positions.
+void trace_gen_default_config(TraceGenConfig *cfg);
+
+// Append a leak point. Return 0, or -1 if the table is full or the point is out of range.
+int trace_gen_add_leak(TraceGenConfig *cfg, int position, int byte, LeakTarget target,
+                       LeakModel model, float gain);
+
+// Generate traces first_index .. first_index + count - 1 into rows 0 .. count - 1 of `set`.
+// Output depends only on the seed and trace index, not on the thread count.
+void trace_gen_fill(const TraceGenConfig *cfg, TraceSet *set, uint64_t first_index, size_t count);
+
+// Generate the whole data set straight to disk. Return 0 on success, -1 on error.
+int trace_gen_write_csv(const TraceGenConfig *cfg, const char *filename);
+int trace_gen_write_bin(const TraceGenConfig *cfg, const char *filename);
+
+// PACKED trace file of the traces quantized to signed Qm.n, generated and
+// encoded batch by batch.
+int trace_gen_write_packed(const TraceGenConfig *cfg, const char *filename, int m, int n);
+
+#endif // _TRACE_GEN_H_
@@ -0,0 +1,210 @@
+// Created by Team "RTL Rangers"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "prefetch.h"
+#include "trace_codec.h"
+#include "trace_store.h"
+
+#define RECORDS_PER_IO 256
+
+int trace_set_alloc(TraceSet *set, size_t num_traces, int trace_length) {
+    memset(set, 0, sizeof(*set));
+    set->num_traces = num_traces;
+    set->trace_length = trace_length;
+    set->owns_memory = 1;
+
+    size_t n = num_traces ? num_traces : 1;
+    set->plaintexts = malloc(n * 16);
+    set->ciphertexts = malloc(n * 16);
+    set->keys = malloc(n * 16);
+    set->traces = malloc(n * (size_t)trace_length * sizeof(float));
+
+    if (!set->plaintexts || !set->ciphertexts || !set->keys || !set->traces) {
+        trace_set_free(set);
+        return -1;
+    }
+    return 0;
+}
+
+void trace_set_free(TraceSet *set) {
+    if (set->owns_memory) {
+        free(set->plaintexts);
+        free(set->ciphertexts);
+        free(set->keys);
+        free(set->traces);
+    }
+    memset(set, 0, sizeof(*set));
+}
+
+static int pwrite_full(int fd, const void *buf, size_t len, uint64_t offset) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+int trace_store_create(const char *filename, uint64_t num_traces, int trace_length,
+                       TraceFileHeader *hdr) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Error: Cannot create file %s\n", filename);
+        return -1;
+    }
+
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, TRACE_FILE_MAGIC, 8);
+    hdr->version = TRACE_FILE_VERSION;
+    hdr->sample_format = TRACE_FORMAT_F32;
+    hdr->num_traces = num_traces;
+    hdr->trace_length = (uint32_t)trace_length;
+    hdr->data_offset = TRACE_FILE_DATA_OFFSET;
+
+    char block[TRACE_FILE_DATA_OFFSET];
+    memset(block, 0, sizeof(block));
+    memcpy(block, hdr, sizeof(*hdr));
+
+    if (pwrite_full(fd, block, sizeof(block), 0) != 0 ||
+        ftruncate(fd, (off_t)trace_record_offset(hdr, num_traces)) != 0) {
+        printf("Error: Cannot write header to %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int trace_store_write_records(int fd, const TraceFileHeader *hdr, const TraceSet *set,
+                              uint64_t first_index, size_t count) {
+    size_t rec_size = trace_record_size(set->trace_length);
+    size_t trace_bytes = (size_t)set->trace_length * sizeof(float);
+    size_t batch = count < RECORDS_PER_IO ? count : RECORDS_PER_IO;
+    char *buf = malloc(batch * rec_size);
+    if (!buf) return -1;
+
+    int rc = 0;
+    for (size_t done = 0; done < count && rc == 0; done += batch) {
+        size_t n = count - done < batch ? count - done : batch;
+        for (size_t r = 0; r < n; r++) {
+            char *rec = buf + r * rec_size;
+            memcpy(rec, set->plaintexts[done + r], 16);
+            memcpy(rec + 16, set->ciphertexts[done + r], 16);
+            memcpy(rec + 32, set->keys[done + r], 16);
+            memcpy(rec + 48, trace_set_row(set, done + r), trace_bytes);
+        }
+        rc = pwrite_full(fd, buf, n * rec_size, trace_record_offset(hdr, first_index + done));
+    }
+
+    free(buf);
+    return rc;
+}
+
+int trace_store_save(const char *filename, const TraceSet *set) {
+    TraceFileHeader hdr;
+    int fd = trace_store_create(filename, set->num_traces, set->trace_length, &hdr);
+    if (fd < 0) return -1;
+
+    int rc = trace_store_write_records(fd, &hdr, set, 0, set->num_traces);
+    if (close(fd) != 0) rc = -1;
+    if (rc != 0) printf("Error: Failed writing %s\n", filename);
+    return rc;
+}
+
+int trace_store_read_header(int fd, TraceFileHeader *hdr) {
+    if (prefetch_pread_full(fd, hdr, sizeof(*hdr), 0) != 0) return -1;
+    if (memcmp(hdr->magic, TRACE_FILE_MAGIC, 8) != 0 || hdr->version != TRACE_FILE_VERSION) {
+        printf("Error: Not a trace file (bad magic or version)\n");
+        return -1;
+    }
+    if (hdr->trace_length == 0 || hdr->data_offset < sizeof(*hdr)) {
+        printf("Error: Corrupt trace file header\n");
+        return -1;
+    }
+    return 0;
+}
+
+long trace_store_load(const char *filename, TraceSet *set, size_t max_traces) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+
+    TraceFileHeader hdr;
+    if (trace_store_read_header(fd, &hdr) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (hdr.sample_format == TRACE_FORMAT_PACKED) {
+        close(fd);
+        return trace_codec_load(filename, set, max_traces, 0);
+    }
+    if (hdr.sample_format != TRACE_FORMAT_F32) {
+        printf("Error: Unsupported sample format %u in %s\n", hdr.sample_format, filename);
+        close(fd);
+        return -1;
+    }
+
+    size_t n = (size_t)hdr.num_traces;
+    if (max_traces && max_traces < n) n = max_traces;
+
+    if (trace_set_alloc(set, n, (int)hdr.trace_length) != 0) {
+        printf("Error: Out of memory loading %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    // Chunks of records are read ahead while earlier ones are unpacked
+    size_t rec_size = trace_record_size(set->trace_length);
+    size_t trace_bytes = (size_t)set->trace_length * sizeof(float);
+    size_t num_ranges = (n + RECORDS_PER_IO - 1) / RECORDS_PER_IO;
+    PrefetchRange *ranges = malloc((num_ranges ? num_ranges : 1) * sizeof(PrefetchRange));
+    Prefetch *pf = NULL;
+    if (ranges) {
+        for (size_t r = 0; r < num_ranges; r++) {
+            size_t done = r * RECORDS_PER_IO;
+            ranges[r].offset = trace_record_offset(&hdr, done);
+            ranges[r].size = (n - done < RECORDS_PER_IO ? n - done : RECORDS_PER_IO) * rec_size;
+        }
+        pf = prefetch_open(fd, ranges, num_ranges, PREFETCH_DEFAULT_DEPTH, 0);
+        free(ranges);
+    }
+    if (!pf) {
+        trace_set_free(set);
+        close(fd);
+        return -1;
+    }
+
+    const uint8_t *buf;
+    size_t size;
+    int rc;
+    for (size_t done = 0; (rc = prefetch_next(pf, &buf, &size)) > 0; done += RECORDS_PER_IO) {
+        size_t cnt = size / rec_size;
+        for (size_t r = 0; r < cnt; r++) {
+            const uint8_t *rec = buf + r * rec_size;
+            memcpy(set->plaintexts[done + r], rec, 16);
+            memcpy(set->ciphertexts[done + r], rec + 16, 16);
+            memcpy(set->keys[done + r], rec + 32, 16);
+            memcpy(trace_set_row(set, done + r), rec + 48, trace_bytes);
+        }
+    }
+
+    prefetch_close(pf);
+    close(fd);
+    if (rc < 0) {
+        printf("Error: Truncated trace file %s\n", filename);
+        trace_set_free(set);
+        return -1;
+    }
+    return (long)n;
+}
@@ -0,0 +1,86 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _TRACE_STORE_H_
+#define _TRACE_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// In-memory trace set: one row of AES data and one power trace per sample.
+typedef struct {
+    size_t num_traces;
+    int trace_length;
+    uint8_t (*plaintexts)[16];
+    uint8_t (*ciphertexts)[16];
+    uint8_t (*keys)[16];
+    float *traces;      // num_traces * trace_length, row-major
+    int owns_memory;    // set by trace_set_alloc, cleared for views of static arrays
+} TraceSet;
+
+// Allocate room for num_traces rows. Return 0 on success, -1 on allocation failure.
+int trace_set_alloc(TraceSet *set, size_t num_traces, int trace_length);
+void trace_set_free(TraceSet *set);
+
+static inline float *trace_set_row(const TraceSet *set, size_t i) {
+    return set->traces + i * (size_t)set->trace_length;
+}
+
+// Binary trace file:
+//   TraceFileHeader, zero padded to TRACE_FILE_DATA_OFFSET, then
+//   TRACE_FORMAT_F32:    num_traces records of { pt[16], ct[16], key[16], float samples[trace_length] }
+//   TRACE_FORMAT_PACKED: independently decodable blocks of block_traces traces, followed by
+//                        a table of num_blocks + 1 uint64 block offsets at index_offset
+//                        (block layout in trace_codec.h)
+#define TRACE_FILE_MAGIC "SCATRACE"
+#define TRACE_FILE_VERSION 1
+#define TRACE_FILE_DATA_OFFSET 4096
+
+enum {
+    TRACE_FORMAT_F32 = 0,    // raw little-endian float32 samples
+    TRACE_FORMAT_PACKED = 1  // int16 samples, delta + zigzag + bit-packed, times sample_scale
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_format;
+    uint64_t num_traces;
+    uint32_t trace_length;
+    uint32_t data_offset;
+    float sample_scale;     // PACKED: float value of one int16 step
+    uint32_t block_traces;  // PACKED: traces per block (last block may be shorter)
+    uint64_t index_offset;  // PACKED: byte offset of the block offset table
+} TraceFileHeader;
+
+static inline size_t trace_record_size(int trace_length) {
+    return 48 + (size_t)trace_length * sizeof(float);
+}
+
+// Byte offset of record i in a TRACE_FORMAT_F32 file
+static inline uint64_t trace_record_offset(const TraceFileHeader *hdr, uint64_t i) {
+    return hdr->data_offset + i * trace_record_size((int)hdr->trace_length);
+}
+
+// Create/truncate `filename` and write a header for num_traces F32 records.
+// Returns the open descriptor for trace_store_write_records, or -1 on error.
+int trace_store_create(const char *filename, uint64_t num_traces, int trace_length,
+                       TraceFileHeader *hdr);
+
+// Write rows [0, count) of `set` as records first_index.. of an open file.
+// Safe to call concurrently on disjoint index ranges. Return 0 or -1.
+int trace_store_write_records(int fd, const TraceFileHeader *hdr, const TraceSet *set,
+                              uint64_t first_index, size_t count);
+
+// Write a whole set as an F32 trace file. Return 0 or -1.
+int trace_store_save(const char *filename, const TraceSet *set);
+
+// Read and validate the header of an open file. Return 0 or -1.
+int trace_store_read_header(int fd, TraceFileHeader *hdr);
+
+// Load up to max_traces records (0 = all) into a freshly allocated set.
+// PACKED files are handed to trace_codec_load.
+// Return the number of traces loaded, or -1 on error.
+long trace_store_load(const char *filename, TraceSet *set, size_t max_traces);
+
+#endif // _TRACE_STORE_H_
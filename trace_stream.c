@@ -0,0 +1,225 @@
+// Created by Team "RTL Rangers"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parallel.h"
+#include "prefetch.h"
+#include "trace_codec.h"
+#include "trace_stream.h"
+
+#define STREAM_DEFAULT_BATCH 1024
+
+struct TraceStream {
+    int fd;
+    TraceFileHeader hdr;
+    size_t num_traces;
+    size_t batch_traces;    // traces per prefetched range
+    size_t delivered;
+    int threads;
+    uint64_t *index;        // PACKED: block offsets of the file
+    Prefetch *pf;
+    TraceSet batch;
+};
+
+// Read and check the block offset table of a PACKED file
+static uint64_t *read_block_index(int fd, const TraceFileHeader *hdr, size_t num_blocks) {
+    struct stat st;
+    if (hdr->block_traces != TRACE_CODEC_BLOCK_TRACES || fstat(fd, &st) != 0) return NULL;
+
+    size_t bytes = (num_blocks + 1) * sizeof(uint64_t);
+    if (hdr->index_offset + bytes > (uint64_t)st.st_size) return NULL;
+    uint64_t *index = malloc(bytes);
+    if (!index) return NULL;
+
+    if (prefetch_pread_full(fd, index, bytes, hdr->index_offset) != 0) {
+        free(index);
+        return NULL;
+    }
+    for (size_t b = 0; b < num_blocks; b++) {
+        if (index[b + 1] < index[b] || index[b + 1] > hdr->index_offset) {
+            free(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+TraceStream *trace_stream_open(const char *filename, size_t batch_traces, size_t max_traces,
+                               int threads) {
+    TraceStream *ts = calloc(1, sizeof(TraceStream));
+    if (!ts) return NULL;
+    ts->threads = threads;
+    ts->fd = open(filename, O_RDONLY);
+    if (ts->fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        free(ts);
+        return NULL;
+    }
+    if (trace_store_read_header(ts->fd, &ts->hdr) != 0) {
+        trace_stream_close(ts);
+        return NULL;
+    }
+
+    ts->num_traces = (size_t)ts->hdr.num_traces;
+    if (max_traces && max_traces < ts->num_traces) ts->num_traces = max_traces;
+    size_t batch = batch_traces ? batch_traces : STREAM_DEFAULT_BATCH;
+    size_t num_ranges;
+    PrefetchRange *ranges;
+
+    if (ts->hdr.sample_format == TRACE_FORMAT_PACKED) {
+        size_t blocks_per = (batch + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES;
+        size_t file_blocks = (size_t)((ts->hdr.num_traces + TRACE_CODEC_BLOCK_TRACES - 1) /
+                                      TRACE_CODEC_BLOCK_TRACES);
+        size_t blocks = (ts->num_traces + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES;
+        ts->batch_traces = blocks_per * TRACE_CODEC_BLOCK_TRACES;
+        ts->index = read_block_index(ts->fd, &ts->hdr, file_blocks);
+        if (!ts->index) {
+            printf("Error: Corrupt packed trace file %s\n", filename);
+            trace_stream_close(ts);
+            return NULL;
+        }
+
+        num_ranges = (blocks + blocks_per - 1) / blocks_per;
+        ranges = malloc((num_ranges ? num_ranges : 1) * sizeof(PrefetchRange));
+        for (size_t r = 0; r < num_ranges && ranges; r++) {
+            size_t b0 = r * blocks_per;
+            size_t b1 = b0 + blocks_per < blocks ? b0 + blocks_per : blocks;
+            ranges[r].offset = ts->index[b0];
+            ranges[r].size = (size_t)(ts->index[b1] - ts->index[b0]);
+        }
+    } else if (ts->hdr.sample_format == TRACE_FORMAT_F32) {
+        size_t rec_size = trace_record_size((int)ts->hdr.trace_length);
+        ts->batch_traces = batch;
+        num_ranges = (ts->num_traces + batch - 1) / batch;
+        ranges = malloc((num_ranges ? num_ranges : 1) * sizeof(PrefetchRange));
+        for (size_t r = 0; r < num_ranges && ranges; r++) {
+            size_t first = r * batch;
+            size_t count = ts->num_traces - first < batch ? ts->num_traces - first : batch;
+            ranges[r].offset = trace_record_offset(&ts->hdr, first);
+            ranges[r].size = count * rec_size;
+        }
+    } else {
+        printf("Error: Unsupported sample format %u in %s\n", ts->hdr.sample_format, filename);
+        trace_stream_close(ts);
+        return NULL;
+    }
+
+    if (!ranges || trace_set_alloc(&ts->batch, ts->batch_traces, (int)ts->hdr.trace_length) != 0) {
+        printf("Error: Out of memory streaming %s\n", filename);
+        free(ranges);
+        trace_stream_close(ts);
+        return NULL;
+    }
+    ts->pf = prefetch_open(ts->fd, ranges, num_ranges, PREFETCH_DEFAULT_DEPTH, 0);
+    free(ranges);
+    if (!ts->pf) {
+        printf("Error: Cannot start reading %s\n", filename);
+        trace_stream_close(ts);
+        return NULL;
+    }
+    return ts;
+}
+
+void trace_stream_close(TraceStream *ts) {
+    if (!ts) return;
+    prefetch_close(ts->pf);
+    trace_set_free(&ts->batch);
+    free(ts->index);
+    if (ts->fd >= 0) close(ts->fd);
+    free(ts);
+}
+
+size_t trace_stream_num_traces(const TraceStream *ts) {
+    return ts->num_traces;
+}
+
+int trace_stream_trace_length(const TraceStream *ts) {
+    return (int)ts->hdr.trace_length;
+}
+
+const char *trace_stream_backend(const TraceStream *ts) {
+    return prefetch_backend(ts->pf);
+}
+
+typedef struct {
+    TraceStream *ts;
+    const uint8_t *data;
+    size_t size;
+    size_t rows;
+    size_t first_block;
+    volatile int error;
+} UnpackTask;
+
+static void unpack_f32_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    UnpackTask *task = (UnpackTask *)ctx;
+    TraceSet *set = &task->ts->batch;
+    size_t rec_size = trace_record_size(set->trace_length);
+    size_t trace_bytes = (size_t)set->trace_length * sizeof(float);
+
+    for (size_t r = begin; r < end; r++) {
+        const uint8_t *rec = task->data + r * rec_size;
+        memcpy(set->plaintexts[r], rec, 16);
+        memcpy(set->ciphertexts[r], rec + 16, 16);
+        memcpy(set->keys[r], rec + 32, 16);
+        memcpy(trace_set_row(set, r), rec + 48, trace_bytes);
+    }
+}
+
+static void decode_packed_worker(void *ctx, size_t begin, size_t end, int worker) {
+    (void)worker;
+    UnpackTask *task = (UnpackTask *)ctx;
+    TraceStream *ts = task->ts;
+    const uint64_t base = ts->index[task->first_block];
+
+    for (size_t b = begin; b < end; b++) {
+        uint64_t lo = ts->index[task->first_block + b] - base;
+        uint64_t hi = ts->index[task->first_block + b + 1] - base;
+        size_t first = b * TRACE_CODEC_BLOCK_TRACES;
+        size_t want = task->rows - first;
+        if (want > TRACE_CODEC_BLOCK_TRACES) want = TRACE_CODEC_BLOCK_TRACES;
+
+        if (hi > task->size ||
+            trace_codec_decode_block(task->data + lo, (size_t)(hi - lo), ts->hdr.sample_scale,
+                                     &ts->batch, first, want) != (long)want) {
+            task->error = 1;
+        }
+    }
+}
+
+long trace_stream_next(TraceStream *ts, TraceSet *batch) {
+    UnpackTask task;
+    memset(&task, 0, sizeof(task));
+    task.ts = ts;
+
+    int rc = prefetch_next(ts->pf, &task.data, &task.size);
+    if (rc <= 0) {
+        if (rc < 0) printf("Error: Read failed while streaming traces\n");
+        return rc;
+    }
+
+    size_t rows = ts->num_traces - ts->delivered;
+    if (rows > ts->batch_traces) rows = ts->batch_traces;
+    task.rows = rows;
+
+    if (ts->hdr.sample_format == TRACE_FORMAT_PACKED) {
+        task.first_block = ts->delivered / TRACE_CODEC_BLOCK_TRACES;
+        size_t blocks = (rows + TRACE_CODEC_BLOCK_TRACES - 1) / TRACE_CODEC_BLOCK_TRACES;
+        parallel_for(blocks, ts->threads, decode_packed_worker, &task);
+        if (task.error) {
+            printf("Error: Corrupt block in packed trace file\n");
+            return -1;
+        }
+    } else {
+        parallel_for(rows, ts->threads, unpack_f32_worker, &task);
+    }
+
+    *batch = ts->batch;
+    batch->num_traces = rows;
+    batch->owns_memory = 0;
+    ts->delivered += rows;
+    return (long)rows;
+}
@@ -0,0 +1,32 @@
+// Created by Team "RTL Rangers"
+
+#ifndef _TRACE_STREAM_H_
+#define _TRACE_STREAM_H_
+
+#include <stddef.h>
+#include "trace_store.h"
+
+// Batch-by-batch reader for binary trace files (F32 or PACKED) that do not
+// need to fit in memory. The file ranges of the following batches are read
+// ahead by prefetch.c while the caller works on the current one, and each
+// batch is unpacked (F32) or decoded (PACKED, one block per task) in parallel.
+typedef struct TraceStream TraceStream;
+
+// batch_traces is rounded up to whole blocks for PACKED files.
+// max_traces = 0 streams the whole file. Return NULL on error.
+TraceStream *trace_stream_open(const char *filename, size_t batch_traces, size_t max_traces,
+                               int threads);
+void trace_stream_close(TraceStream *ts);
+
+// Traces the stream will deliver in total
+size_t trace_stream_num_traces(const TraceStream *ts);
+int trace_stream_trace_length(const TraceStream *ts);
+
+// Fill `batch` with a view of the next traces, valid until the following call.
+// Return the number of traces, 0 at the end of the file, or -1 on error.
+long trace_stream_next(TraceStream *ts, TraceSet *batch);
+
+// I/O backend used for the read-ahead
+const char *trace_stream_backend(const TraceStream *ts);
+
+#endif // _TRACE_STREAM_H_